@@ -13,6 +13,7 @@
 #include "common.h"
 
 
+int on_handle_local_options(GApplication* app, GVariantDict* values, void* user_data);
 int on_command_line(GApplication* app, GApplicationCommandLine* cli, void* user_data);
 void on_activate(GApplication* gapp, void* user_data);
 
@@ -0,0 +1,19 @@
+/**
+ * cache.h
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "common.h"
+
+
+int cache_load_file(lua_State* L, const char* path);
+void cache_register_searcher(lua_State* L, const char* cwd);
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * collector.h
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include "common.h"
+
+#define COLLECTOR_SLICE_USEC 2000
+
+
+typedef struct {
+  unsigned steps; // run while idle
+  unsigned cycles; // finished by the idle steps
+  unsigned fulls;
+  gint64 step_time; // microseconds
+  gint64 full_time;
+  gint64 max_pause; // the longest slice or full collection
+} CollectorStats;
+
+// Runs the garbage collector of Lua while the terminal is idle, in addition to the steps driven by
+// allocations.
+typedef struct {
+  lua_State* L;
+  gint64 delay; // microseconds without input before stepping, 0 to disable
+  gint64 last_input;
+  unsigned wake_tag;
+  unsigned step_tag;
+  int default_pause; // of Lua, restored by 0
+  int default_stepmul;
+  bool generational;
+  CollectorStats stats;
+} Collector;
+
+
+Collector* collector_init(lua_State* L);
+void collector_close(Collector* collector);
+void collector_set_idle_delay(Collector* collector, int msec);
+void collector_set_params(Collector* collector, int pause, int stepmul);
+bool collector_set_generational(Collector* collector, bool generational);
+void collector_touch(Collector* collector);
+void collector_collect(Collector* collector);
+
+#endif
@@ -16,20 +16,32 @@
 
 
 typedef struct {
-  GHashTable* data;
+  char* str;
+  int integer;
+  bool boolean;
+  bool assigned;
+  bool has_color; // `color` is parsed from `str`
+  GdkRGBA color;
+} ConfigSlot;
+
+typedef struct {
+  ConfigSlot* slots; // indexed by MetaEntry->index
+  unsigned size;
   bool locked;
 } Config;
 
 
-Config* config_init();
+Config* config_init(unsigned size);
 void config_close(Config* config);
 void config_restore_default(Config* config, Meta* meta);
-const char* config_get_str(Config* config, const char* key);
-void config_set_str(Config* config, const char* key, const char* value);
-int config_get_int(Config* config, const char* key);
-void config_set_int(Config* config, const char* key, int value);
-bool config_get_bool(Config* config, const char* key);
-void config_set_bool(Config* config, const char* key, bool value);
+const char* config_get_str(Config* config, unsigned index);
+void config_set_str(Config* config, unsigned index, const char* value);
+const GdkRGBA* config_get_color(Config* config, unsigned index);
+bool config_set_color(Config* config, unsigned index, const char* value);
+int config_get_int(Config* config, unsigned index);
+void config_set_int(Config* config, unsigned index, int value);
+bool config_get_bool(Config* config, unsigned index);
+void config_set_bool(Config* config, unsigned index, bool value);
 VteCursorShape config_get_cursor_shape(Config* config);
 VteCursorBlinkMode config_get_cursor_blink_mode(Config* config);
 unsigned config_get_cjk_width(Config* config);
@@ -11,47 +11,135 @@
 #define CONTEXT_H
 
 #include "common.h"
+#include "collector.h"
 #include "config.h"
+#include "coro.h"
 #include "hook.h"
 #include "keymap.h"
+#include "memory.h"
 #include "option.h"
+#include "palette.h"
+#include "profile.h"
+#include "task.h"
+#include "timer.h"
 
 
 typedef struct {
   bool config_loading;
   bool initialized;
+  bool daemon;
+  unsigned signal_subscription;
+  unsigned busy; // nested main loops running under a Lua function
+  bool closing; // closed once nothing runs under it
+  unsigned close_tag;
+  unsigned chord_tag; // performs the prefix of the pending chord when keymap_timeout expires
 } State;
 
+typedef struct {
+  unsigned depth;
+  bool font;
+  bool scale;
+  bool size;
+  bool palette;
+  bool uri_schemes;
+  int scale_value;
+  int width;
+  int height;
+} Batch;
+
+typedef struct {
+  double delta_x;
+  double delta_y;
+  GdkEvent* event; // copy of the latest event, replayed with the summed deltas
+  unsigned tick_id;
+  bool replaying;
+} Scroll;
+
+typedef struct {
+  bool title;
+  unsigned bells;
+  unsigned tag;
+} Coalesce;
+
+typedef struct {
+  unsigned tag; // debounce timeout
+  bool requesting; // reading the primary clipboard
+} Selection;
+
 typedef struct {
   GtkWindow* window;
   VteTerminal* vte;
   GtkBox* hbox;
   GtkBox* vbox;
   int uri_tag;
+  VteRegex* uri_regex; // owned by the entry of `uri_schemes` in the cache of the primary context
+  char* uri_schemes; // the value `uri_regex` is compiled from
   bool alpha_supported;
+  GdkPixbuf* background_pixbuf;
+  cairo_surface_t* background_surface; // `background_pixbuf` scaled to cover the window
+  GCancellable* background_cancellable;
+  char* background_path; // resolved path of the image loaded or loading
+  gint64 background_mtime;
 } Layout;
 
+typedef struct _Context Context;
+
+typedef void (*ClipboardFunc)(Context* context, const char* text, void* user_data);
+typedef void (*ClipboardReleaseFunc)(Context* context, void* user_data);
+
 typedef struct {
+  Context* context; // NULL once the context is closed
+  ClipboardFunc func; // NULL once cancelled
+  ClipboardReleaseFunc release; // called instead of `func` when it is cancelled or the context is closed
+  void* user_data;
+} ClipboardRequest;
+
+struct _Context {
   Meta* meta;
   Option* option;
   Config* config;
   Keymap* keymap;
   Hook* hook;
+  Timer* timer;
+  TaskQueue* task;
+  Memory* memory;
+  Collector* collector;
+  Profile* profile;
+  Palette* palette;
   GApplication* app;
   GdkDevice* device;
   lua_State* lua;
   Layout layout;
   State state;
-} Context;
+  Batch batch;
+  Scroll scroll;
+  Coalesce coalesce;
+  Selection selection;
+  GList* clipboard_requests;
+  GHashTable* uri_regexes; // compiled URI regexes shared by the windows, only in the primary context
+  char* cwd; // of the client which opened the window through the daemon, NULL for the own one
+  char** env;
+  Context* primary;
+  GList* siblings;
+};
 
 
 Context* context_init();
+Context* context_init_window(Context* primary);
 void context_close(Context* context);
+void context_request_close(Context* context);
 int context_start(Context* context, int argc, char **argv);
+void context_load_profile(Context* context);
 void context_load_device(Context* context);
 void context_load_lua_context(Context* context);
+void context_apply_lua_budget(Context* context);
+void context_apply_gc_params(Context* context);
+void context_begin_batch(Context* context);
+void context_end_batch(Context* context);
 void context_restore_default(Context* context);
 void context_override_by_option(Context* context);
+char* context_get_cwd(Context* context);
+char** context_get_environ(Context* context);
 char* context_acquire_config_path(Context* context);
 char* context_acquire_theme_path(Context* context);
 void context_load_config(Context* context);
@@ -61,6 +149,9 @@ void context_handle_signal(Context* context, const char* signal_name, GVariant*
 void context_build_layout(Context* context);
 void context_notify(Context* context, const char* body, const char* title);
 void context_launch_uri(Context* context, const char* uri);
+ClipboardRequest* context_request_text(Context* context, GdkAtom selection, ClipboardFunc func, ClipboardReleaseFunc release, void* user_data);
+void context_cancel_request(ClipboardRequest* request);
+char* context_wait_for_text(Context* context, GdkAtom selection);
 GdkWindow* context_get_gdk_window(Context* context);
 const char* context_get_str(Context* context, const char* key);
 int context_get_int(Context* context, const char* key);
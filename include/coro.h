@@ -0,0 +1,68 @@
+/**
+ * coro.h
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef CORO_H
+#define CORO_H
+
+#include "common.h"
+#include "memory.h"
+
+#define CORO_POOL_SIZE 4
+#define CORO_WATCHDOG_STEP 1000
+
+
+typedef void (*CoroErrorFunc)(void* user_data, const char* message);
+
+typedef struct {
+  int time; // milliseconds, 0 for no limit
+  int instructions; // 0 for no limit
+} CoroBudget;
+
+// A run from `lua_resume()` until it returns, which is the unit of the budget.
+typedef struct _CoroRun CoroRun;
+struct _CoroRun {
+  CoroBudget budget;
+  gint64 deadline;
+  lua_Integer count;
+  bool aborted;
+  CoroRun* outer;
+};
+
+typedef struct {
+  GList* waits; // suspended coroutines
+  int pool[CORO_POOL_SIZE]; // refs to finished threads which can run again
+  unsigned pool_size;
+  CoroBudget budget; // for the functions without their own budget
+  CoroRun* current;
+  CoroErrorFunc on_error;
+  void* error_data;
+} Coro;
+
+typedef struct {
+  Coro* coro;
+  lua_State* co;
+  int ref; // keeps `co` alive while it is suspended
+  unsigned tag;
+  CoroBudget budget;
+  MemoryPhase phase; // restored on resume
+} CoroWait;
+
+
+void coro_init(lua_State* L);
+void coro_close(lua_State* L);
+int coro_run(lua_State* L, int narg, int nresult);
+bool coro_is_managed(lua_State* L);
+CoroWait* coro_wait_new(lua_State* L);
+void coro_wait_resume(CoroWait* wait, int narg);
+int coro_sleep(lua_State* L, unsigned msec);
+void coro_set_error_handler(lua_State* L, CoroErrorFunc func, void* user_data);
+void coro_set_budget(lua_State* L, int time, int instructions);
+void coro_set_function_budget(lua_State* L, int index, const CoroBudget* budget);
+
+#endif
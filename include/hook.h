@@ -11,20 +11,68 @@
 #define HOOK_H
 
 #include "common.h"
+#include "coro.h"
 
 
+typedef enum {
+  HOOK_TITLE,
+  HOOK_BELL,
+  HOOK_CLICKED,
+  HOOK_SCROLL,
+  HOOK_DRAG,
+  HOOK_ACTIVATED,
+  HOOK_DEACTIVATED,
+  HOOK_SELECTED,
+  HOOK_UNSELECTED,
+  HOOK_COUNT,
+} HookType;
+
+typedef struct {
+  unsigned buttons; // bit of each accepted button, 0 for any
+  unsigned mods; // modifiers which must be held
+  GRegex* regex; // tested against the title, URI, path or selected text
+  gint64 interval; // minimum microseconds between calls
+  gint64 last_time;
+} HookFilter;
+
 typedef struct {
-  GHashTable* refs;
+  int handle;
+  HookType type;
+  int ref; // LUA_NOREF once removed
+  int priority;
+  HookFilter* filter; // NULL if every event is passed
+} HookSubscriber;
+
+typedef struct {
+  GPtrArray* subscribers[HOOK_COUNT]; // higher priority first
+  int set_handles[HOOK_COUNT]; // subscriber of `tym.set_hook()`, 0 if not set
+  int last_handle;
+  unsigned dispatching;
+  GSList* pending; // subscribers added while dispatching
+  bool dirty; // subscribers removed while dispatching
 } Hook;
 
 
 Hook* hook_init();
 void hook_close(Hook* hook);
-bool hook_set_ref(Hook* hook, const char* key, int ref, int* old_ref);
+bool hook_get_type(const char* key, HookType* type);
+int hook_add(Hook* hook, HookType type, int ref, int priority, HookFilter* filter);
+bool hook_remove(Hook* hook, int handle, int* ref);
+bool hook_set_ref(Hook* hook, const char* key, int ref, HookFilter* filter, int* old_ref);
+HookFilter* hook_filter_new(lua_State* L, int index);
+void hook_filter_free(HookFilter* filter);
+bool hook_filter_match(HookFilter* filter, int button, unsigned mods, const char* text);
+
+// Callers check this before preparing arguments, so that events without hooks never touch Lua.
+static inline bool hook_has(Hook* hook, HookType type)
+{
+  return hook->subscribers[type]->len > 0;
+}
+
 bool hook_perform_title(Hook* hook, lua_State* L, const char* title, bool* result);
-bool hook_perform_bell(Hook* hook, lua_State* L, bool* result);
-bool hook_perform_clicked(Hook* hook, lua_State* L, int button, const char* uri, bool* result);
-bool hook_perform_scroll(Hook* hook, lua_State* L, double delta_x, double delta_y, double x, double y, bool* result);
+bool hook_perform_bell(Hook* hook, lua_State* L, unsigned count, bool* result);
+bool hook_perform_clicked(Hook* hook, lua_State* L, int button, unsigned mods, const char* uri, bool* result);
+bool hook_perform_scroll(Hook* hook, lua_State* L, double delta_x, double delta_y, double x, double y, unsigned mods, bool* result);
 bool hook_perform_drag(Hook* hook, lua_State* L, char* path, bool* result);
 bool hook_perform_activated(Hook* hook, lua_State* L);
 bool hook_perform_deactivated(Hook* hook, lua_State* L);
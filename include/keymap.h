@@ -11,18 +11,49 @@
 #define KEYMAP_H
 
 #include "common.h"
+#include "coro.h"
 
+#define KEYMAP_DEFAULT_MODE "default"
+
+
+typedef struct {
+  unsigned key;
+  GdkModifierType mod;
+  int ref; // LUA_NOREF if not assigned by user
+  int default_id; // -1 if no default action
+} KeymapBinding;
+
+// A node of the trie of key strokes. The path from the root of a mode is a chord like `<Ctrl>a c`.
+typedef struct _KeymapNode KeymapNode;
+struct _KeymapNode {
+  KeymapBinding binding;
+  GHashTable* children; // (key, mod) -> KeymapNode, NULL if no chord continues
+};
 
 typedef struct {
-  GList* entries;
+  GHashTable* modes; // name -> root KeymapNode
+  KeymapNode* root; // root of the current mode
+  GArray* defaults; // KeymapBinding of the default actions, which also match with extra modifiers
+  char* mode;
+  KeymapNode* pending; // set while waiting for the rest of a chord
+  gint64 pending_since;
+  unsigned timeout; // in milliseconds, 0 to wait forever
+  bool ignore_default;
 } Keymap;
 
 
 Keymap* keymap_init();
 void keymap_close(Keymap* keymap);
 void keymap_reset(Keymap* keymap);
-bool keymap_add_entry(Keymap* keymap, const char* accelerator, int ref);
-bool keymap_remove_entry(Keymap* keymap, const char* accelerator);
-bool keymap_perform(Keymap* keymap, lua_State* L, unsigned key, GdkModifierType mod, bool* result, char** error);
+void keymap_add_default(Keymap* keymap, unsigned key, GdkModifierType mod, int id);
+void keymap_set_ignore_default(Keymap* keymap, bool ignore);
+void keymap_set_timeout(Keymap* keymap, unsigned timeout);
+void keymap_set_mode(Keymap* keymap, const char* mode);
+bool keymap_add_entry(Keymap* keymap, const char* accelerator, const char* mode, int ref);
+bool keymap_remove_entry(Keymap* keymap, const char* accelerator, const char* mode);
+const KeymapBinding* keymap_lookup(Keymap* keymap, unsigned key, GdkModifierType mod, bool* pending, const KeymapBinding** prefix);
+const KeymapBinding* keymap_get_pending(Keymap* keymap);
+const KeymapBinding* keymap_expire(Keymap* keymap);
+bool keymap_perform(Keymap* keymap, lua_State* L, const KeymapBinding* binding, bool* result, char** error);
 
 #endif
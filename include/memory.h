@@ -0,0 +1,56 @@
+/**
+ * memory.h
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "common.h"
+
+
+// What the Lua state is running, to which the allocations are counted.
+typedef enum {
+  MEMORY_PHASE_OTHER,
+  MEMORY_PHASE_CONFIG,
+  MEMORY_PHASE_THEME,
+  MEMORY_PHASE_HOOK,
+  MEMORY_PHASE_KEYMAP,
+  MEMORY_PHASE_TIMER,
+  MEMORY_PHASE_TASK,
+  MEMORY_PHASE_COUNT,
+} MemoryPhase;
+
+typedef struct {
+  size_t allocated; // bytes
+  size_t freed;
+} MemoryCount;
+
+typedef struct {
+  size_t used; // bytes in use by the Lua state
+  size_t peak;
+  size_t limit; // 0 for no limit
+  unsigned refused; // allocations refused by `limit`
+  unsigned depth; // protected calls in progress, the only place `limit` is enforced
+  MemoryPhase phase;
+  MemoryCount counts[MEMORY_PHASE_COUNT];
+} Memory;
+
+
+Memory* memory_init();
+void memory_close(Memory* memory);
+lua_State* memory_new_state(Memory* memory);
+Memory* memory_get(lua_State* L);
+const char* memory_get_phase_name(MemoryPhase phase);
+MemoryPhase memory_set_phase(lua_State* L, MemoryPhase phase);
+void memory_set_limit(Memory* memory, size_t limit);
+void memory_enter(lua_State* L);
+void memory_leave(lua_State* L);
+unsigned memory_suspend(lua_State* L);
+void memory_restore(lua_State* L, unsigned depth);
+
+#endif
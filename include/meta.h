@@ -11,9 +11,17 @@
 #define META_H
 
 #include "common.h"
+#include "schema.h"
 
 typedef void  (*MetaCallback) (void);
 
+typedef enum {
+#define X(key) META_KEY_##key,
+  TYM_META_KEYS(X)
+#undef X
+  META_KEY_COUNT,
+} MetaKey;
+
 typedef enum {
   META_ENTRY_TYPE_STRING = 0,
   META_ENTRY_TYPE_INTEGER = 1,
@@ -22,13 +30,13 @@ typedef enum {
 } MetaEntryType;
 
 typedef struct {
-  char* name;
+  const char* name;
   char short_name;
   MetaEntryType type;
   GOptionFlags option_flag;
-  void* default_value;
-  char* arg_desc;
-  char* desc;
+  const void* default_value;
+  const char* arg_desc;
+  const char* desc;
   MetaCallback getter;
   MetaCallback setter;
   bool is_theme;
@@ -36,13 +44,15 @@ typedef struct {
 } MetaEntry;
 
 typedef struct {
-  GHashTable* data;
-  GList* list;
+  const MetaEntry* entries;
+  // default values indexed by MetaEntry->index, which also covers ones depending on the environment
+  const void* defaults[META_KEY_COUNT];
+  char* default_shell;
 } Meta;
 
 Meta* meta_init();
 void meta_close(Meta* meta);
 unsigned meta_size(Meta* meta);
-MetaEntry* meta_get_entry(Meta* meta, const char* key);
+const MetaEntry* meta_get_entry(Meta* meta, const char* key);
 
 #endif
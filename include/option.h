@@ -17,9 +17,11 @@ typedef struct {
   GOptionEntry* entries;
   bool version;
   bool nolua;
+  bool no_bytecode_cache;
   char* config_path;
   char* theme_path;
   char* signal;
+  char* profile_startup;
   GVariantDict* values;
 } Option;
 
@@ -35,6 +37,8 @@ bool option_get_version(Option* option);
 char* option_get_config_path(Option* option);
 char* option_get_theme_path(Option* option);
 char* option_get_signal(Option* option);
+char* option_get_profile_startup(Option* option);
 bool option_get_nolua(Option* option);
+bool option_get_no_bytecode_cache(Option* option);
 
 #endif
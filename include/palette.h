@@ -0,0 +1,29 @@
+/**
+ * palette.h
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include "common.h"
+
+#define PALETTE_SIZE 16
+
+
+typedef struct {
+  GdkRGBA colors[PALETTE_SIZE];
+  bool dirty;
+} Palette;
+
+
+Palette* palette_init();
+void palette_close(Palette* palette);
+bool palette_set_color(Palette* palette, unsigned index, const char* value);
+void palette_apply(Palette* palette, VteTerminal* vte);
+
+#endif
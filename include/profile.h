@@ -0,0 +1,33 @@
+/**
+ * profile.h
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "common.h"
+
+#define TYM_PROFILE_FORMAT_TABLE "table"
+#define TYM_PROFILE_FORMAT_JSON "json"
+
+
+typedef struct {
+  GPtrArray* entries;
+  gint64 origin;
+  bool json;
+} Profile;
+
+
+Profile* profile_init(const char* format);
+void profile_close(Profile* profile);
+gint64 profile_begin(Profile* profile);
+void profile_end(Profile* profile, const char* label, gint64 start);
+void profile_mark(Profile* profile, const char* label);
+void profile_report(Profile* profile);
+
+#endif
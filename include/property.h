@@ -27,6 +27,9 @@ typedef void (*PropertyStrSetterWithExtra)(Context* context, const char* key, co
 typedef void (*PropertyBoolSetterWithExtra)(Context* context, const char* key, bool value, void* extra);
 
 
+void property_commit_batch(Context* context);
+void property_release_uri_regex(Context* context);
+
 // str
 void setter_shell(Context* context, const char* key, const char* value);
 
@@ -74,10 +77,22 @@ void setter_padding_vertical(Context* context, const char* key, int value);
 int getter_scrollback_length(Context* context, const char* key);
 void setter_scrollback_length(Context* context, const char* key, int value);
 
+void setter_keymap_timeout(Context* context, const char* key, int value);
+void setter_timer_slack(Context* context, const char* key, int value);
+void setter_lua_time_budget(Context* context, const char* key, int value);
+void setter_lua_instruction_budget(Context* context, const char* key, int value);
+void setter_lua_memory_limit(Context* context, const char* key, int value);
+void setter_gc_mode(Context* context, const char* key, const char* value);
+void setter_gc_idle_delay(Context* context, const char* key, int value);
+void setter_gc_pause(Context* context, const char* key, int value);
+void setter_gc_step_multiplier(Context* context, const char* key, int value);
+
 // bool
 bool getter_silent(Context* context, const char* key);
 void setter_silent(Context* context, const char* key, bool value);
 
+void setter_ignore_default_keymap(Context* context, const char* key, bool value);
+
 bool getter_autohide(Context* context, const char* key);
 void setter_autohide(Context* context, const char* key, bool value);
 
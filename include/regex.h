@@ -16,6 +16,13 @@
  *     - absolute-URI       special case of URI. not distinguishable in regex.
  *     - path               not referenced from any other rules.
  *     - path-empty         to avoid highlighting meaningless URI like `foo:`.
+ *   * The characters of SCHEME do not include `:` nor SP, so it is repeated possessively.
+ *   * Everything after `:` is followed only by rules which can match empty, so the first match found
+ *     never has to be given up. Therefore rules are wrapped in atomic groups `(?>...)` and repeated
+ *     with possessive quantifiers `*+` / `++` to keep the engine from backtracking into them, which
+ *     does not change what is matched. Repeats followed by a mandatory token (like `USERINFO` by `@`)
+ *     are possessive only when the token can not be matched by the repeated rule. `DEC_OCTET` and
+ *     `IPV6ADDRESS` are left as they are because their alternatives rely on backtracking.
  *
  * Copyright (c) 2020 endaaman, iTakeshi
  *
@@ -46,7 +53,7 @@
  * rules to validate the user-configured scheme list
  */
 
-#define SCHEME          "(" ALPHA "(?:" ALPHA "|" DIGIT "|" "[\\+\\-\\.]" ")*" ")"
+#define SCHEME          "(" ALPHA "(?:" ALPHA "|" DIGIT "|" "[\\+\\-\\.]" ")*+" ")"
 
 #define SCHEME_LIST     SCHEME "(?:" SP SCHEME ")*"
 
@@ -55,21 +62,21 @@
  * main rules
  */
 
-#define SCHEMELESS_URI  "(?:" ":" HIER_PART "(?:" "\\?" QUERY ")?" "(?:" "\\#" FRAGMENT ")?" ")"
+#define SCHEMELESS_URI  "(?>" ":" HIER_PART "(?:" "\\?" QUERY ")?+" "(?:" "\\#" FRAGMENT ")?+" ")"
 
-#define HIER_PART       "(?:" "\\/\\/" AUTHORITY PATH_ABEMPTY "|" PATH_ABSOLUTE "|" PATH_ROOTLESS ")"
+#define HIER_PART       "(?>" "\\/\\/" AUTHORITY PATH_ABEMPTY "|" PATH_ABSOLUTE "|" PATH_ROOTLESS ")"
 
-#define AUTHORITY       "(?:" USERINFO "@" ")?" HOST "(?:" ":" PORT ")?"
+#define AUTHORITY       "(?:" USERINFO "@" ")?+" HOST "(?:" ":" PORT ")?+"
 
-#define USERINFO        "(?:" UNRESERVED "|" PCT_ENCODED "|" SUB_DELIMS "|" ":" ")*"
+#define USERINFO        "(?:" UNRESERVED "|" PCT_ENCODED "|" SUB_DELIMS "|" ":" ")*+"
 
-#define HOST            "(?:" IP_LITERAL "|" IPV4ADDRESS "|" REG_NAME")"
+#define HOST            "(?>" IP_LITERAL "|" IPV4ADDRESS "|" REG_NAME")"
 
-#define PORT            "(?:" DIGIT ")*"
+#define PORT            "(?:" DIGIT ")*+"
 
 #define IP_LITERAL      "(?:" "\\[" "(?:" IPV6ADDRESS "|" IPVFUTURE ")" "\\]" ")"
 
-#define IPVFUTURE       "(?:" "v" "(?:" HEXDIG ")+" "\\." "(?:" UNRESERVED "|" SUB_DELIMS "|" ":" ")+" ")"
+#define IPVFUTURE       "(?:" "v" "(?:" HEXDIG ")++" "\\." "(?:" UNRESERVED "|" SUB_DELIMS "|" ":" ")++" ")"
 
 #define IPV6ADDRESS     "(?:"                                            "(?:" H16 ":" "){6}" LS32 \
                           "|"                                       "::" "(?:" H16 ":" "){5}" LS32 \
@@ -90,23 +97,23 @@
 
 #define DEC_OCTET       "(?:" DIGIT "|" "[1-9]" DIGIT "|" "1" DIGIT DIGIT "|" "2" "[0-4]" DIGIT "|" "25" "[0-5]" ")"
 
-#define REG_NAME        "(?:" UNRESERVED "|" PCT_ENCODED "|" SUB_DELIMS ")*"
+#define REG_NAME        "(?:" UNRESERVED "|" PCT_ENCODED "|" SUB_DELIMS ")*+"
 
-#define PATH_ABEMPTY    "(?:" "\\/" SEGMENT ")*"
+#define PATH_ABEMPTY    "(?:" "\\/" SEGMENT ")*+"
 
-#define PATH_ABSOLUTE   "(?:" "\\/" "(?:" SEGMENT_NZ PATH_ABEMPTY ")?" ")"
+#define PATH_ABSOLUTE   "(?:" "\\/" "(?:" SEGMENT_NZ PATH_ABEMPTY ")?+" ")"
 
 #define PATH_ROOTLESS   "(?:" SEGMENT_NZ PATH_ABEMPTY ")"
 
-#define SEGMENT         "(?:" PCHAR ")*"
+#define SEGMENT         "(?:" PCHAR ")*+"
 
-#define SEGMENT_NZ      "(?:" PCHAR ")+"
+#define SEGMENT_NZ      "(?:" PCHAR ")++"
 
 #define PCHAR           "(?:" UNRESERVED "|" PCT_ENCODED "|" SUB_DELIMS "|" ":" "|" "@" ")"
 
-#define QUERY           "(?:" PCHAR "|" "\\/" "|" "\\?" ")*"
+#define QUERY           "(?:" PCHAR "|" "\\/" "|" "\\?" ")*+"
 
-#define FRAGMENT        "(?:" PCHAR "|" "\\/" "|" "\\?" ")*"
+#define FRAGMENT        "(?:" PCHAR "|" "\\/" "|" "\\?" ")*+"
 
 #define PCT_ENCODED     "(?:" "%" HEXDIG HEXDIG ")"
 
@@ -0,0 +1,82 @@
+/**
+ * schema.h
+ *
+ * Keys of the config in the order of MetaEntry->index.
+ *
+ * This file is shared by meta.c and by meta-hash-gen, which generates the perfect hash of
+ * the keys at build time, so it must not depend on anything but the C standard headers.
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#define TYM_META_KEYS(X) \
+  /* STR */ \
+  X(shell) \
+  X(term) \
+  X(title) \
+  X(font) \
+  X(icon) \
+  X(role) \
+  X(cursor_shape) \
+  X(cursor_blink_mode) \
+  X(cjk_width) \
+  X(background_image) \
+  X(uri_schemes) \
+  X(gc_mode) \
+  /* INT */ \
+  X(width) \
+  X(height) \
+  X(scale) \
+  X(padding_horizontal) \
+  X(padding_vertical) \
+  X(scrollback_length) \
+  X(keymap_timeout) \
+  X(coalesce_interval) \
+  X(selection_debounce) \
+  X(timer_slack) \
+  X(lua_time_budget) \
+  X(lua_instruction_budget) \
+  X(lua_memory_limit) \
+  X(gc_idle_delay) \
+  X(gc_pause) \
+  X(gc_step_multiplier) \
+  /* BOOL */ \
+  X(ignore_default_keymap) \
+  X(autohide) \
+  X(silent) \
+  X(coalesce_scroll) \
+  /* COLOR */ \
+  X(color_0)  X(color_1)  X(color_2)  X(color_3) \
+  X(color_4)  X(color_5)  X(color_6)  X(color_7) \
+  X(color_8)  X(color_9)  X(color_10) X(color_11) \
+  X(color_12) X(color_13) X(color_14) X(color_15) \
+  X(color_window_background) \
+  X(color_background) \
+  X(color_foreground) \
+  X(color_bold) \
+  X(color_cursor) \
+  X(color_cursor_foreground) \
+  X(color_highlight) \
+  X(color_highlight_foreground)
+
+// FNV-1a with a final avalanche so that the low bits used as the slot depend on the seed
+static inline unsigned schema_hash(const char* key, unsigned seed)
+{
+  unsigned h = 2166136261u ^ seed;
+  for (; *key; key++) {
+    h ^= (unsigned char)*key;
+    h *= 16777619u;
+  }
+  h ^= h >> 15;
+  h *= 0x2c1b3c6du;
+  h ^= h >> 12;
+  return h;
+}
+
+#endif
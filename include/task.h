@@ -0,0 +1,57 @@
+/**
+ * task.h
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "common.h"
+#include "coro.h"
+
+#define TASK_SLICE_USEC 4000
+
+
+// All of them are below G_PRIORITY_DEFAULT, where input events and the output of the child are handled.
+typedef enum {
+  TASK_PRIORITY_HIGH, // before redrawing
+  TASK_PRIORITY_NORMAL,
+  TASK_PRIORITY_IDLE,
+  TASK_PRIORITY_COUNT,
+} TaskPriority;
+
+typedef void (*TaskFunc)(void* data);
+
+typedef struct {
+  TaskFunc func; // NULL for a Lua function
+  void* data;
+  GDestroyNotify destroy;
+  lua_State* L;
+  int ref;
+} Task;
+
+typedef struct _TaskQueue TaskQueue;
+
+typedef struct {
+  TaskQueue* queue;
+  TaskPriority priority;
+  GQueue tasks;
+  unsigned tag;
+} TaskClass;
+
+struct _TaskQueue {
+  TaskClass classes[TASK_PRIORITY_COUNT];
+};
+
+
+TaskQueue* task_init();
+void task_close(TaskQueue* queue);
+bool task_parse_priority(const char* name, TaskPriority* priority);
+void task_push(TaskQueue* queue, TaskPriority priority, TaskFunc func, void* data, GDestroyNotify destroy);
+void task_push_lua(TaskQueue* queue, TaskPriority priority, lua_State* L, int ref);
+
+#endif
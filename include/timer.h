@@ -0,0 +1,45 @@
+/**
+ * timer.h
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "common.h"
+#include "coro.h"
+
+
+typedef struct {
+  int id;
+  int ref;
+  gint64 deadline; // monotonic time in microseconds
+  gint64 interval;
+  bool fixed; // `tym.set_interval()`, repeated at fixed rate until cleared
+  bool due; // taken out of the queue to run
+  bool cleared; // cleared while it is due
+} TimerEntry;
+
+typedef struct {
+  lua_State* L;
+  GList* queue; // TimerEntry sorted by deadline
+  int last_id;
+  gint64 slack;
+  unsigned tag; // the only source which wakes up the timers
+  gint64 wakeup;
+  GList* due;
+  bool running; // in the wakeup, which a function can re-enter by a nested main loop
+} Timer;
+
+
+Timer* timer_init(lua_State* L);
+void timer_close(Timer* timer);
+void timer_set_slack(Timer* timer, int msec);
+int timer_add(Timer* timer, int ref, int msec, bool fixed);
+bool timer_remove(Timer* timer, int id);
+
+#endif
@@ -12,7 +12,16 @@
 
 #include "common.h"
 
+void test_collector();
 void test_config();
+void test_coro();
+void test_hook();
+void test_keymap();
+void test_memory();
+void test_meta();
+void test_palette();
 void test_regex();
+void test_task();
+void test_timer();
 
 #endif
@@ -32,6 +32,9 @@ rm -f src/*.o
 rm -f src/*.trs
 rm -f src/Makefile
 rm -f src/Makefile.in
+rm -f src/meta-hash-gen
+rm -f src/meta-hash.h
+rm -f src/regex-bench
 rm -f src/tym
 rm -f src/tym-test
 rm -rf src/.deps/
@@ -49,9 +49,21 @@ static void on_vte_drag_data_received(
   g_regex_unref(regex);
 }
 
+static void touch_collector(Context* context)
+{
+  if (context->collector) {
+    collector_touch(context->collector);
+  }
+}
+
 static bool on_vte_key_press(GtkWidget* widget, GdkEventKey* event, void* user_data)
 {
   Context* context = (Context*)user_data;
+  touch_collector(context);
+  if (event->is_modifier) {
+    // pressing Shift or Ctrl for the next stroke must not break the chord
+    return false;
+  }
 
   unsigned mod = event->state & gtk_accelerator_get_default_mod_mask();
   unsigned key = gdk_keyval_to_lower(event->keyval);
@@ -62,11 +74,68 @@ static bool on_vte_key_press(GtkWidget* widget, GdkEventKey* event, void* user_d
   return false;
 }
 
+static gboolean on_vte_scroll_tick(GtkWidget* widget, GdkFrameClock* clock, void* user_data)
+{
+  Context* context = (Context*)user_data;
+  Scroll* scroll = &context->scroll;
+  GdkEventScroll* e = (GdkEventScroll*)scroll->event;
+  scroll->tick_id = 0;
+  scroll->event = NULL;
+
+  bool result = false;
+  unsigned mod = e->state & gtk_accelerator_get_default_mod_mask();
+  if (!(hook_perform_scroll(context->hook, context->lua, scroll->delta_x, scroll->delta_y, e->x, e->y, mod, &result) && result)) {
+    // let VTE scroll by the sum as one smooth scroll
+    e->direction = GDK_SCROLL_SMOOTH;
+    e->delta_x = scroll->delta_x;
+    e->delta_y = scroll->delta_y;
+    scroll->replaying = true;
+    gtk_widget_event(widget, (GdkEvent*)e);
+    scroll->replaying = false;
+  }
+  scroll->delta_x = 0;
+  scroll->delta_y = 0;
+  gdk_event_free((GdkEvent*)e);
+  return G_SOURCE_REMOVE;
+}
+
+// Sums up the deltas until the next frame. Discrete scrolls count as one unit.
+static void coalesce_scroll(Context* context, GtkWidget* widget, GdkEventScroll* e)
+{
+  Scroll* scroll = &context->scroll;
+  switch (e->direction) {
+    case GDK_SCROLL_UP: scroll->delta_y -= 1; break;
+    case GDK_SCROLL_DOWN: scroll->delta_y += 1; break;
+    case GDK_SCROLL_LEFT: scroll->delta_x -= 1; break;
+    case GDK_SCROLL_RIGHT: scroll->delta_x += 1; break;
+    case GDK_SCROLL_SMOOTH:
+      scroll->delta_x += e->delta_x;
+      scroll->delta_y += e->delta_y;
+      break;
+  }
+  if (scroll->event) {
+    gdk_event_free(scroll->event);
+  }
+  scroll->event = gdk_event_copy((GdkEvent*)e);
+  if (!scroll->tick_id) {
+    scroll->tick_id = gtk_widget_add_tick_callback(widget, on_vte_scroll_tick, context, NULL);
+  }
+}
+
 static bool on_vte_mouse_scroll(GtkWidget* widget, GdkEventScroll* e, void* user_data)
 {
   Context* context = (Context*)user_data;
+  touch_collector(context);
+  if (context->scroll.replaying || !hook_has(context->hook, HOOK_SCROLL)) {
+    return false;
+  }
+  if (config_get_bool(context->config, META_KEY_coalesce_scroll)) {
+    coalesce_scroll(context, widget, e);
+    return true;
+  }
   bool result = false;
-  if (hook_perform_scroll(context->hook, context->lua, e->delta_x, e->delta_y, e->x, e->y, &result) && result) {
+  unsigned mod = e->state & gtk_accelerator_get_default_mod_mask();
+  if (hook_perform_scroll(context->hook, context->lua, e->delta_x, e->delta_y, e->x, e->y, mod, &result) && result) {
     return true;
   }
   return false;
@@ -75,28 +144,46 @@ static bool on_vte_mouse_scroll(GtkWidget* widget, GdkEventScroll* e, void* user
 static void on_vte_child_exited(VteTerminal* vte, int status, void* user_data)
 {
   Context* context = (Context*)user_data;
+  if (context->primary) {
+    // only this window is closed and the daemon keeps serving the others
+    context_request_close(context);
+    return;
+  }
   g_application_quit(G_APPLICATION(context->app));
 }
 
-static void on_vte_title_changed(VteTerminal* vte, void* user_data)
+static void on_window_destroy(GtkWidget* widget, void* user_data)
 {
   Context* context = (Context*)user_data;
+  // the widgets are gone, so the context must not touch them any more
+  g_signal_handlers_disconnect_by_data(context->layout.vte, context);
+  g_signal_handlers_disconnect_by_data(widget, context);
+  context->layout.window = NULL;
+  context->layout.vte = NULL;
+  if (context->primary) {
+    // closed by the window manager, which does not make the child exit first
+    context_request_close(context);
+  }
+}
+
+static void perform_title(Context* context)
+{
   GtkWindow* window = context->layout.window;
   bool result = false;
   const char* title = vte_terminal_get_window_title(context->layout.vte);
   if (hook_perform_title(context->hook, context->lua, title, &result) && result) {
     return;
   }
-  if (title) {
+  // setting the same title still costs a roundtrip to the display server
+  if (title && g_strcmp0(gtk_window_get_title(window), title) != 0) {
     gtk_window_set_title(window, title);
   }
 }
 
-static void on_vte_bell(VteTerminal* vte, void* user_data)
+static void perform_bell(Context* context, unsigned count)
 {
-  Context* context = (Context*)user_data;
   bool result = false;
-  if (hook_perform_bell(context->hook, context->lua, &result) && result) {
+  if (hook_perform_bell(context->hook, context->lua, count, &result) && result) {
     return;
   }
   GtkWindow* window = context->layout.window;
@@ -105,15 +192,67 @@ static void on_vte_bell(VteTerminal* vte, void* user_data)
   }
 }
 
+static gboolean on_coalesce_timeout(void* user_data)
+{
+  Context* context = (Context*)user_data;
+  Coalesce* coalesce = &context->coalesce;
+  coalesce->tag = 0;
+  if (coalesce->title) {
+    coalesce->title = false;
+    perform_title(context);
+  }
+  if (coalesce->bells) {
+    unsigned count = coalesce->bells;
+    coalesce->bells = 0;
+    perform_bell(context, count);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+// Returns false if the event has to be handled at once.
+static bool coalesce(Context* context)
+{
+  int interval = config_get_int(context->config, META_KEY_coalesce_interval);
+  if (interval <= 0) {
+    return false;
+  }
+  if (!context->coalesce.tag) {
+    context->coalesce.tag = g_timeout_add(interval, on_coalesce_timeout, context);
+  }
+  return true;
+}
+
+static void on_vte_title_changed(VteTerminal* vte, void* user_data)
+{
+  Context* context = (Context*)user_data;
+  if (coalesce(context)) {
+    context->coalesce.title = true;
+    return;
+  }
+  perform_title(context);
+}
+
+static void on_vte_bell(VteTerminal* vte, void* user_data)
+{
+  Context* context = (Context*)user_data;
+  if (coalesce(context)) {
+    context->coalesce.bells++;
+    return;
+  }
+  perform_bell(context, 1);
+}
+
 static bool on_vte_click(VteTerminal* vte, GdkEventButton* event, void* user_data)
 {
   Context* context = (Context*)user_data;
+  touch_collector(context);
   char* uri = NULL;
   if (context->layout.uri_tag >= 0) {
     uri = vte_terminal_match_check_event(vte, (GdkEvent*)event, NULL);
   }
   bool result = false;
-  if (hook_perform_clicked(context->hook, context->lua, event->button, uri, &result) && result) {
+  unsigned mod = event->state & gtk_accelerator_get_default_mod_mask();
+  if (hook_perform_clicked(context->hook, context->lua, event->button, mod, uri, &result) && result) {
     return true;
   }
   if (uri) {
@@ -123,16 +262,90 @@ static bool on_vte_click(VteTerminal* vte, GdkEventButton* event, void* user_dat
   return false;
 }
 
-static void on_vte_selection_changed(GtkWidget* widget, void* user_data)
+typedef struct {
+  Context* context;
+  HookType type;
+  char* text;
+} DeferredHook;
+
+static void perform_deferred_hook(void* data)
+{
+  DeferredHook* d = (DeferredHook*)data;
+  Context* context = d->context;
+  switch (d->type) {
+    case HOOK_ACTIVATED: hook_perform_activated(context->hook, context->lua); break;
+    case HOOK_DEACTIVATED: hook_perform_deactivated(context->hook, context->lua); break;
+    case HOOK_SELECTED: hook_perform_selected(context->hook, context->lua, d->text); break;
+    case HOOK_UNSELECTED: hook_perform_unselected(context->hook, context->lua); break;
+    default: break;
+  }
+}
+
+static void free_deferred_hook(void* data)
+{
+  DeferredHook* d = (DeferredHook*)data;
+  g_free(d->text);
+  g_free(d);
+}
+
+// For the hooks whose results do not change the default actions, so the output of the child is not delayed by them.
+static void defer_hook(Context* context, HookType type, const char* text)
+{
+  if (!context->lua || !hook_has(context->hook, type)) {
+    return;
+  }
+  DeferredHook* d = g_malloc0(sizeof(DeferredHook));
+  d->context = context;
+  d->type = type;
+  d->text = g_strdup(text);
+  task_push(context->task, TASK_PRIORITY_NORMAL, perform_deferred_hook, d, free_deferred_hook);
+}
+
+#ifndef TYM_USE_VTE_GET_TEXT_SELECTED
+static void on_selection_text_received(Context* context, const char* text, void* user_data)
+{
+  context->selection.requesting = false;
+  defer_hook(context, HOOK_SELECTED, text);
+}
+#endif
+
+static gboolean on_selection_settled(void* user_data)
 {
   Context* context = (Context*)user_data;
+  context->selection.tag = 0;
   if (!vte_terminal_get_has_selection(context->layout.vte)) {
-    hook_perform_unselected(context->hook, context->lua);
+    defer_hook(context, HOOK_UNSELECTED, NULL);
+    return G_SOURCE_REMOVE;
+  }
+  if (!hook_has(context->hook, HOOK_SELECTED)) {
+    return G_SOURCE_REMOVE;
+  }
+#ifdef TYM_USE_VTE_GET_TEXT_SELECTED
+  char* text = vte_terminal_get_text_selected(context->layout.vte, VTE_FORMAT_TEXT);
+  defer_hook(context, HOOK_SELECTED, text);
+  g_free(text);
+#else
+  // read asynchronously instead of spinning a nested main loop
+  if (!context->selection.requesting) {
+    context->selection.requesting = true;
+    context_request_text(context, GDK_SELECTION_PRIMARY, on_selection_text_received, NULL, NULL);
+  }
+#endif
+  return G_SOURCE_REMOVE;
+}
+
+// Fires on every motion while dragging, so the hooks are called once the selection settles.
+static void on_vte_selection_changed(GtkWidget* widget, void* user_data)
+{
+  Context* context = (Context*)user_data;
+  if (!hook_has(context->hook, HOOK_SELECTED) && !hook_has(context->hook, HOOK_UNSELECTED)) {
     return;
   }
-  GtkClipboard* cb = gtk_clipboard_get(GDK_SELECTION_PRIMARY);
-  char* text = gtk_clipboard_wait_for_text(cb);
-  hook_perform_selected(context->hook, context->lua, text);
+  if (context->selection.tag) {
+    g_source_remove(context->selection.tag);
+  }
+  int debounce = config_get_int(context->config, META_KEY_selection_debounce);
+  context->selection.tag = g_timeout_add(MAX(debounce, 0), on_selection_settled, context);
 }
 
 
@@ -146,6 +359,7 @@ static void on_vte_spawn(VteTerminal* vte, GPid pid, GError* error, void* user_d
     g_application_quit(context->app);
     return;
   }
+  profile_mark(context->profile, "child spawned");
 }
 #endif
 
@@ -153,34 +367,95 @@ static bool on_window_focus_in(GtkWindow* window, GdkEvent* event, void* user_da
 {
   Context* context = (Context*)user_data;
   gtk_window_set_urgency_hint(window, false);
-  hook_perform_activated(context->hook, context->lua);
+  defer_hook(context, HOOK_ACTIVATED, NULL);
   return false;
 }
 
 static bool on_window_focus_out(GtkWindow* window, GdkEvent* event, void* user_data)
 {
   Context* context = (Context*)user_data;
-  hook_perform_deactivated(context->hook, context->lua);
+  defer_hook(context, HOOK_DEACTIVATED, NULL);
+  if (context->collector) {
+    // nobody is waiting for the window now
+    collector_collect(context->collector);
+  }
+  return false;
+}
+
+static gboolean on_vte_first_draw(GtkWidget* widget, cairo_t* cr, void* user_data)
+{
+  Context* context = (Context*)user_data;
+  profile_mark(context->profile, "first draw");
+  g_signal_handlers_disconnect_by_func(widget, G_CALLBACK(on_vte_first_draw), user_data);
   return false;
 }
 
+// The image is scaled to cover the window only when the size changes, and the old one is evicted.
+static cairo_surface_t* get_background_surface(Context* context, int width, int height)
+{
+  Layout* layout = &context->layout;
+  if (!layout->background_pixbuf) {
+    return NULL;
+  }
+  cairo_surface_t* surface = layout->background_surface;
+  if (surface
+      && cairo_image_surface_get_width(surface) == width
+      && cairo_image_surface_get_height(surface) == height) {
+    return surface;
+  }
+  g_clear_pointer(&layout->background_surface, cairo_surface_destroy);
+  surface = layout->background_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+  GdkPixbuf* pixbuf = layout->background_pixbuf;
+  double image_width = gdk_pixbuf_get_width(pixbuf);
+  double image_height = gdk_pixbuf_get_height(pixbuf);
+  double scale = MAX(width / image_width, height / image_height);
+  cairo_t* cr = cairo_create(surface);
+  cairo_translate(cr, (width - image_width * scale) / 2, (height - image_height * scale) / 2);
+  cairo_scale(cr, scale, scale);
+  gdk_cairo_set_source_pixbuf(cr, pixbuf, 0, 0);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+  return surface;
+}
+
 static gboolean on_window_draw(GtkWidget* widget, cairo_t* cr, void* user_data)
 {
   Context* context = (Context*)user_data;
-  const char* value = context_get_str(context, "color_window_background");
-  if (is_none(value)) {
+  const GdkRGBA* color = config_get_color(context->config, META_KEY_color_window_background);
+  int width = gtk_widget_get_allocated_width(widget);
+  int height = gtk_widget_get_allocated_height(widget);
+  cairo_surface_t* image = get_background_surface(context, width, height);
+  if (!color && !image) {
     return false;
   }
-  GdkRGBA color = {};
-  if (gdk_rgba_parse(&color, value)) {
+  // the clip must not leak into drawing the children
+  cairo_save(cr);
+  // When VTE clears its own background, only the padding around VTE is visible.
+  if (!is_none(config_get_str(context->config, META_KEY_color_background))) {
+    GtkWidget* vte = GTK_WIDGET(context->layout.vte);
+    int x = 0;
+    int y = 0;
+    gtk_widget_translate_coordinates(vte, widget, 0, 0, &x, &y);
+    cairo_rectangle(cr, 0, 0, width, height);
+    cairo_rectangle(cr, x, y, gtk_widget_get_allocated_width(vte), gtk_widget_get_allocated_height(vte));
+    cairo_set_fill_rule(cr, CAIRO_FILL_RULE_EVEN_ODD);
+    cairo_clip(cr);
+  }
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  if (color) {
     if (context->layout.alpha_supported) {
-      cairo_set_source_rgba(cr, color.red, color.green, color.blue, color.alpha);
+      cairo_set_source_rgba(cr, color->red, color->green, color->blue, color->alpha);
     } else {
-      cairo_set_source_rgb(cr, color.red, color.green, color.blue);
+      cairo_set_source_rgb(cr, color->red, color->green, color->blue);
     }
-    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+  }
+  if (image) {
+    cairo_set_source_surface(cr, image, 0, 0);
     cairo_paint(cr);
   }
+  cairo_restore(cr);
   return false;
 }
 
@@ -196,6 +471,18 @@ void on_dbus_signal(
   context_handle_signal((Context*)user_data, signal_name, parameters);
 }
 
+int on_handle_local_options(GApplication* app, GVariantDict* values, void* user_data)
+{
+  df();
+  Context* context = (Context*)user_data;
+  if (g_variant_dict_contains(values, "daemon")) {
+    // the first instance becomes primary and the following ones forward their command line to it
+    context->state.daemon = true;
+    g_application_set_flags(app, g_application_get_flags(app) & ~G_APPLICATION_NON_UNIQUE);
+  }
+  return -1;
+}
+
 int on_command_line(GApplication* app, GApplicationCommandLine* cli, void* user_data)
 {
   df();
@@ -204,7 +491,7 @@ int on_command_line(GApplication* app, GApplicationCommandLine* cli, void* user_
   option_load_from_cli(context->option, cli);
   bool version = option_get_version(context->option);
   if (version) {
-    g_print("version %s\n", PACKAGE_VERSION);
+    g_application_command_line_print(cli, "version %s\n", PACKAGE_VERSION);
     return 0;
   }
   char* signal = option_get_signal(context->option);
@@ -221,6 +508,14 @@ int on_command_line(GApplication* app, GApplicationCommandLine* cli, void* user_
     }
     return 0;
   }
+  if (context->state.daemon) {
+    Context* window_context = context_init_window(context);
+    window_context->cwd = g_strdup(g_application_command_line_get_cwd(cli));
+    window_context->env = g_strdupv((char**)g_application_command_line_get_environ(cli));
+    option_load_from_cli(window_context->option, cli);
+    on_activate(app, window_context);
+    return 0;
+  }
   g_application_activate(app);
   return 0;
 }
@@ -230,21 +525,31 @@ void on_activate(GApplication* app, void* user_data)
   GError* error = NULL;
 
   df();
-  GtkWindow* w = gtk_application_get_active_window(GTK_APPLICATION(app));
-  if (w) {
-    gtk_window_present(w);
+  Context* context = (Context*)user_data;
+  if (context->layout.window) {
+    gtk_window_present(context->layout.window);
     return;
   }
 
-  Context* context = (Context*)user_data;
-  context_load_device(context);
-  context_load_lua_context(context);
-
-  context_build_layout(context);
-  context_restore_default(context);
-  context_load_theme(context);
-  context_load_config(context);
-  context_override_by_option(context);
+  context_load_profile(context);
+#define PROFILE(expr) \
+  do { \
+    gint64 started_at = profile_begin(context->profile); \
+    expr; \
+    profile_end(context->profile, #expr, started_at); \
+  } while (0)
+
+  PROFILE(context_load_device(context));
+  PROFILE(context_load_lua_context(context));
+
+  PROFILE(context_build_layout(context));
+  // apply font, size and palette once before the window is shown
+  context_begin_batch(context);
+  PROFILE(context_restore_default(context));
+  PROFILE(context_load_theme(context));
+  PROFILE(context_load_config(context));
+  PROFILE(context_override_by_option(context));
+  PROFILE(context_end_batch(context));
 
   VteTerminal* vte = context->layout.vte;
   GtkWindow* window = context->layout.window;
@@ -265,11 +570,15 @@ void on_activate(GApplication* app, void* user_data)
   g_signal_connect(window, "focus-in-event", G_CALLBACK(on_window_focus_in), context);
   g_signal_connect(window, "focus-out-event", G_CALLBACK(on_window_focus_out), context);
   g_signal_connect(window, "draw", G_CALLBACK(on_window_draw), context);
+  g_signal_connect(window, "destroy", G_CALLBACK(on_window_destroy), context);
+  if (context->profile) {
+    g_signal_connect_after(vte, "draw", G_CALLBACK(on_vte_first_draw), context);
+  }
 
   const char* path = g_application_get_dbus_object_path(app);
   dd("DBus is active: %s", path);
   GDBusConnection* conn = g_application_get_dbus_connection(app);
-  g_dbus_connection_signal_subscribe(
+  context->state.signal_subscription = g_dbus_connection_signal_subscribe(
     conn,
     NULL,       // sender
     TYM_APP_ID, // interface_name
@@ -291,14 +600,15 @@ void on_activate(GApplication* app, void* user_data)
     g_application_quit(app);
     return;
   }
-  char** env = g_get_environ();
+  char** env = context_get_environ(context);
   env = g_environ_setenv(env, "TERM", context_get_str(context, "term"), true);
+  gint64 spawn_started_at = profile_begin(context->profile);
 
 #ifdef TYM_USE_VTE_SPAWN_ASYNC
   vte_terminal_spawn_async(
     vte,                 // terminal
     VTE_PTY_DEFAULT,     // pty flag
-    NULL,                // working directory
+    context->cwd,        // working directory
     argv,                // argv
     env,                 // envv
     G_SPAWN_SEARCH_PATH, // spawn_flags
@@ -315,7 +625,7 @@ void on_activate(GApplication* app, void* user_data)
   vte_terminal_spawn_sync(
     vte,
     VTE_PTY_DEFAULT,
-    NULL,
+    context->cwd,
     argv,
     env,
     G_SPAWN_SEARCH_PATH,
@@ -335,9 +645,11 @@ void on_activate(GApplication* app, void* user_data)
     return;
   }
 #endif
+  profile_end(context->profile, "spawn", spawn_started_at);
 
   g_strfreev(env);
   g_strfreev(argv);
   gtk_widget_grab_focus(GTK_WIDGET(vte));
-  gtk_widget_show_all(GTK_WIDGET(window));
+  PROFILE(gtk_widget_show_all(GTK_WIDGET(window)));
+#undef PROFILE
 }
@@ -17,7 +17,7 @@ static int builtin_get(lua_State* L)
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
 
   const char* key = luaL_checkstring(L, 1);
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (!e) {
     luaX_warn(L, "Invalid config key: '%s'", key);
     lua_pushnil(L);
@@ -42,6 +42,16 @@ static int builtin_get(lua_State* L)
 }
 
 
+static void profile_set(Context* context, const char* key, gint64 started_at)
+{
+  if (!context->profile || !context->state.config_loading) {
+    return;
+  }
+  char* label = g_strconcat("set: ", key, NULL);
+  profile_end(context->profile, label, started_at);
+  g_free(label);
+}
+
 static int builtin_quit(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
@@ -55,12 +65,13 @@ static int builtin_set(lua_State* L)
 
   const char* key = luaL_checkstring(L, 1);
 
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (!e) {
     luaX_warn(L, "Invalid config key: '%s'", key);
     return 0;
   }
 
+  gint64 started_at = profile_begin(context->profile);
   int type = lua_type(L, 2);
   switch (e->type) {
     case META_ENTRY_TYPE_STRING: {
@@ -89,6 +100,7 @@ static int builtin_set(lua_State* L)
     default:
       break;
   }
+  profile_set(context, key, started_at);
   return 0;
 }
 
@@ -97,22 +109,23 @@ static int get_default_value(lua_State* L)
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
 
   const char* key = luaL_checkstring(L, 1);
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (!e) {
     luaX_warn(L, "Invalid config key: '%s'", key);
     lua_pushnil(L);
     return 1;
   }
 
+  const void* default_value = context->meta->defaults[e->index];
   switch (e->type) {
     case META_ENTRY_TYPE_STRING:
-      lua_pushstring(L, (char*)e->default_value);
+      lua_pushstring(L, (const char*)default_value);
       break;
     case META_ENTRY_TYPE_INTEGER:
-      lua_pushinteger(L, *(int*)e->default_value);
+      lua_pushinteger(L, *(const int*)default_value);
       break;
     case META_ENTRY_TYPE_BOOLEAN:
-      lua_pushboolean(L, *(bool*)e->default_value);
+      lua_pushboolean(L, *(const bool*)default_value);
       break;
     default:
       lua_pushnil(L);
@@ -127,9 +140,9 @@ static int builtin_get_config(lua_State* L)
 
   lua_newtable(L);
 
-  for (GList* li = context->meta->list; li != NULL; li = li->next) {
-    MetaEntry* e = (MetaEntry*)li->data;
-    char* key = e->name;
+  for (unsigned i = 0; i < meta_size(context->meta); i++) {
+    const MetaEntry* e = &context->meta->entries[i];
+    const char* key = e->name;
     lua_pushstring(L, key);
     switch (e->type) {
       case META_ENTRY_TYPE_STRING: {
@@ -158,12 +171,14 @@ static int builtin_set_config(lua_State* L)
 
   luaL_argcheck(L, lua_istable(L, 1), 1, "table expected");
 
+  context_begin_batch(context);
   lua_pushnil(L);
   while (lua_next(L, -2)) {
     lua_pushvalue(L, -2);
     const char* key = lua_tostring(L, -1);
-    MetaEntry* e = meta_get_entry(context->meta, key);
+    const MetaEntry* e = meta_get_entry(context->meta, key);
     if (e) {
+      gint64 started_at = profile_begin(context->profile);
       int type = lua_type(L, -2);
       switch (e->type) {
         case META_ENTRY_TYPE_STRING: {
@@ -192,15 +207,60 @@ static int builtin_set_config(lua_State* L)
         default:
           break;
       }
+      profile_set(context, key, started_at);
     } else {
       luaX_warn(L, "Invalid config key: '%s'", key);
     }
     lua_pop(L, 2);
   }
+  context_end_batch(context);
+
+  return 0;
+}
+
+static int builtin_set_palette(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
 
+  luaL_argcheck(L, lua_istable(L, 1), 1, "table expected");
+
+  // `palette[1]` .. `palette[16]` are `color_0` .. `color_15` and they are uploaded at once
+  context_begin_batch(context);
+  char key[10] = {};
+  for (unsigned i = 0; i < PALETTE_SIZE; i++) {
+    lua_rawgeti(L, 1, i + 1);
+    if (!lua_isnil(L, -1)) {
+      const char* value = lua_tostring(L, -1);
+      g_snprintf(key, sizeof(key), "color_%d", i);
+      if (value) {
+        context_set_str(context, key, value);
+      } else {
+        luaX_warn(L, "Invalid string config for '%s' (string expected, got %s)", key, luaL_typename(L, -1));
+      }
+    }
+    lua_pop(L, 1);
+  }
+  context_end_batch(context);
   return 0;
 }
 
+// `func` is called with `lua_pcall()`, so it cannot wait. The batch belongs to the whole context, and
+// holding it across a yield would defer the changes of every other caller until the coroutine resumes.
+static int builtin_batch(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  luaL_checktype(L, 1, LUA_TFUNCTION);
+  lua_settop(L, 1);
+
+  context_begin_batch(context);
+  int result = lua_pcall(L, 0, LUA_MULTRET, 0);
+  context_end_batch(context);
+  if (result != LUA_OK) {
+    return lua_error(L);
+  }
+  return lua_gettop(L);
+}
+
 static int builtin_reset_config(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
@@ -214,9 +274,11 @@ static int builtin_set_keymap(lua_State* L)
 
   const char* key = luaL_checkstring(L, 1);
   luaL_argcheck(L, lua_isfunction(L, 2), 2, "function expected");
+  const char* mode = luaL_optstring(L, 3, NULL);
 
+  lua_pushvalue(L, 2);
   int ref = luaL_ref(L, LUA_REGISTRYINDEX);
-  bool ok = keymap_add_entry(context->keymap, key, ref);
+  bool ok = keymap_add_entry(context->keymap, key, mode, ref);
   if (!ok) {
     luaL_unref(L, LUA_REGISTRYINDEX, ref);
     luaX_warn(L, "Invalid accelerator: '%s'", key);
@@ -229,7 +291,8 @@ static int builtin_unset_keymap(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
   const char* key = luaL_checkstring(L, 1);
-  bool removed = keymap_remove_entry(context->keymap, key);
+  const char* mode = luaL_optstring(L, 2, NULL);
+  bool removed = keymap_remove_entry(context->keymap, key, mode);
   if (!removed) {
     luaX_warn(L, "Tried to remove en empty keymap '(%s') which is not assigned function to", key);
   }
@@ -241,6 +304,8 @@ static int builtin_set_keymaps(lua_State* L)
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
 
   luaL_argcheck(L, lua_istable(L, 1), 1, "table expected");
+  const char* mode = luaL_optstring(L, 2, NULL);
+  lua_pushvalue(L, 1); // the table has to be on the top for `lua_next()`
 
   lua_pushnil(L);
   while (lua_next(L, -2)) {
@@ -251,7 +316,7 @@ static int builtin_set_keymaps(lua_State* L)
     } else {
       lua_pushvalue(L, -2); // push function to stack top
       int ref = luaL_ref(L, LUA_REGISTRYINDEX);
-      bool ok = keymap_add_entry(context->keymap, key, ref);
+      bool ok = keymap_add_entry(context->keymap, key, mode, ref);
       if (!ok) {
         luaL_unref(L, LUA_REGISTRYINDEX, ref);
         luaX_warn(L, "Invalid accelerator: '%s'", key);
@@ -270,20 +335,40 @@ static int builtin_reset_keymaps(lua_State* L)
   return 0;
 }
 
+static int builtin_set_mode(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  const char* mode = luaL_optstring(L, 1, KEYMAP_DEFAULT_MODE);
+  keymap_set_mode(context->keymap, mode);
+  return 0;
+}
+
+static int builtin_get_mode(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  lua_pushstring(L, context->keymap->mode);
+  return 1;
+}
+
 static int builtin_set_hook(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
   const char* key = luaL_checkstring(L, 1);
   luaL_argcheck(L, lua_isfunction(L, 2), 2, "function expected");
+  luaL_argcheck(L, lua_isnoneornil(L, 3) || lua_istable(L, 3), 3, "table expected");
+  // compiled before the ref is taken because an invalid filter raises an error
+  HookFilter* filter = lua_istable(L, 3) ? hook_filter_new(L, 3) : NULL;
+  lua_pushvalue(L, 2);
   int ref = luaL_ref(L, LUA_REGISTRYINDEX);
   int old_ref = -1;
-  if (hook_set_ref(context->hook, key, ref, &old_ref)) {
+  if (hook_set_ref(context->hook, key, ref, filter, &old_ref)) {
     if (old_ref > 0) {
       dd("unref old ref");
       luaL_unref(L, LUA_REGISTRYINDEX, old_ref);
     }
     return 0;
   }
+  hook_filter_free(filter);
   luaL_unref(L, LUA_REGISTRYINDEX, ref);
   luaX_warn(L, "Invalid hook key: '%s'", key);
   return 0;
@@ -303,7 +388,7 @@ static int builtin_set_hooks(lua_State* L)
       lua_pushvalue(L, -2); // push function to stack top
       int ref = luaL_ref(L, LUA_REGISTRYINDEX);
       int old_ref = -1;
-      int ok = hook_set_ref(context->hook, key, ref, &old_ref);
+      int ok = hook_set_ref(context->hook, key, ref, NULL, &old_ref);
       if (old_ref > 0) {
         dd("unref old ref");
         luaL_unref(L, LUA_REGISTRYINDEX, old_ref);
@@ -318,6 +403,38 @@ static int builtin_set_hooks(lua_State* L)
   return 0;
 }
 
+static int builtin_add_hook(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  const char* key = luaL_checkstring(L, 1);
+  luaL_argcheck(L, lua_isfunction(L, 2), 2, "function expected");
+  int priority = luaL_optinteger(L, 3, 0);
+  luaL_argcheck(L, lua_isnoneornil(L, 4) || lua_istable(L, 4), 4, "table expected");
+  HookType type;
+  if (!hook_get_type(key, &type)) {
+    luaX_warn(L, "Invalid hook key: '%s'", key);
+    return 0;
+  }
+  HookFilter* filter = lua_istable(L, 4) ? hook_filter_new(L, 4) : NULL;
+  lua_pushvalue(L, 2);
+  int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  lua_pushinteger(L, hook_add(context->hook, type, ref, priority, filter));
+  return 1;
+}
+
+static int builtin_remove_hook(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  int handle = luaL_checkinteger(L, 1);
+  int ref = LUA_NOREF;
+  bool removed = hook_remove(context->hook, handle, &ref);
+  if (ref > 0) {
+    luaL_unref(L, LUA_REGISTRYINDEX, ref);
+  }
+  lua_pushboolean(L, removed);
+  return 1;
+}
+
 static int builtin_reload(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
@@ -362,57 +479,136 @@ static int builtin_send_key(lua_State* L)
   return 0;
 }
 
-typedef struct {
-  Context* context;
-  int ref;
-} TimeoutNotation;
-
-static int timeout_callback(void* user_data)
+static int builtin_set_timeout(lua_State* L)
 {
-  TimeoutNotation* notation = (TimeoutNotation*) user_data;
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
 
-  lua_State* L = notation->context->lua;
-  lua_rawgeti(L, LUA_REGISTRYINDEX, notation->ref);
-  if (!lua_isfunction(L, -1)) {
-    lua_pop(L, 1); // pop none-function
-    dd("tried to call non-function");
-    return false;
-  }
+  luaL_argcheck(L, lua_isfunction(L, 1), 1, "function expected");
+  int interval = lua_tointeger(L, 2); // if non-number, falling back to 0
 
-  if (lua_pcall(L, 0, 1, 0) != LUA_OK) {
-    luaX_warn(L, "Error in timeout function: '%s'", lua_tostring(L, -1));
-    lua_pop(L, 1); // error
-    return false;
-  }
-  bool result = lua_toboolean(L, -1);
-  lua_pop(L, 1);
-  return result;
+  lua_pushvalue(L, 1);
+  int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  lua_pushinteger(L, timer_add(context->timer, ref, interval, false));
+  return 1;
 }
 
-static int builtin_set_timeout(lua_State* L)
+static int builtin_set_interval(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
 
   luaL_argcheck(L, lua_isfunction(L, 1), 1, "function expected");
-  int interval = lua_tointeger(L, 2); // if non-number, falling back to 0
+  int interval = luaL_checkinteger(L, 2);
+  luaL_argcheck(L, interval > 0, 2, "positive integer expected");
 
   lua_pushvalue(L, 1);
   int ref = luaL_ref(L, LUA_REGISTRYINDEX);
-  TimeoutNotation* notation = g_malloc0(sizeof(TimeoutNotation));
-  notation->context = context;
-  notation->ref = ref;
-  int tag = g_timeout_add_full(G_PRIORITY_DEFAULT, interval, (GSourceFunc)timeout_callback, notation, g_free);
-  lua_pushinteger(L, tag);
+  lua_pushinteger(L, timer_add(context->timer, ref, interval, true));
   return 1;
 }
 
 static int builtin_clear_timeout(lua_State* L)
 {
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
   int tag = luaL_checkinteger(L, 1);
-  g_source_remove(tag);
+  timer_remove(context->timer, tag);
   return 0;
 }
 
+static int builtin_defer(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  luaL_argcheck(L, lua_isfunction(L, 1), 1, "function expected");
+  const char* name = luaL_optstring(L, 2, "normal");
+  TaskPriority priority;
+  if (!task_parse_priority(name, &priority)) {
+    luaX_warn(L, "Invalid priority(`%s`): 'high', 'normal' or 'idle' is available.", name);
+    return 0;
+  }
+  lua_pushvalue(L, 1);
+  task_push_lua(context->task, priority, context->lua, luaL_ref(L, LUA_REGISTRYINDEX));
+  return 0;
+}
+
+static int builtin_sleep(lua_State* L)
+{
+  int msec = luaL_checkinteger(L, 1);
+  luaL_argcheck(L, msec >= 0, 1, "non-negative integer expected");
+  if (!coro_is_managed(L)) {
+    return luaL_error(L, "tym.sleep() can be called only in hooks, keymaps and timeouts, and not in tym.batch()");
+  }
+  return coro_sleep(L, msec);
+}
+
+static int builtin_set_budget(lua_State* L)
+{
+  luaL_argcheck(L, lua_isfunction(L, 1), 1, "function expected");
+  if (lua_isnoneornil(L, 2) && lua_isnoneornil(L, 3)) {
+    coro_set_function_budget(L, 1, NULL);
+    return 0;
+  }
+  CoroBudget budget = {
+    .time = luaL_optinteger(L, 2, 0),
+    .instructions = luaL_optinteger(L, 3, 0),
+  };
+  luaL_argcheck(L, budget.time >= 0, 2, "non-negative integer expected");
+  luaL_argcheck(L, budget.instructions >= 0, 3, "non-negative integer expected");
+  coro_set_function_budget(L, 1, &budget);
+  return 0;
+}
+
+static int builtin_get_memory_stats(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  Memory* memory = context->memory;
+  lua_createtable(L, 0, 5);
+  lua_pushinteger(L, memory->used);
+  lua_setfield(L, -2, "used");
+  lua_pushinteger(L, memory->peak);
+  lua_setfield(L, -2, "peak");
+  lua_pushinteger(L, memory->limit);
+  lua_setfield(L, -2, "limit");
+  lua_pushinteger(L, memory->refused);
+  lua_setfield(L, -2, "refused");
+  lua_createtable(L, 0, MEMORY_PHASE_COUNT);
+  for (unsigned i = 0; i < MEMORY_PHASE_COUNT; i++) {
+    lua_createtable(L, 0, 2);
+    lua_pushinteger(L, memory->counts[i].allocated);
+    lua_setfield(L, -2, "allocated");
+    lua_pushinteger(L, memory->counts[i].freed);
+    lua_setfield(L, -2, "freed");
+    lua_setfield(L, -2, memory_get_phase_name(i));
+  }
+  lua_setfield(L, -2, "phases");
+  return 1;
+}
+
+static int builtin_gc_stats(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  Collector* collector = context->collector;
+  CollectorStats* stats = &collector->stats;
+  lua_createtable(L, 0, 9);
+  lua_pushstring(L, collector->generational ? TYM_GC_MODE_GENERATIONAL : TYM_GC_MODE_INCREMENTAL);
+  lua_setfield(L, -2, "mode");
+  lua_pushinteger(L, lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0));
+  lua_setfield(L, -2, "count");
+  lua_pushinteger(L, stats->steps);
+  lua_setfield(L, -2, "idle_steps");
+  lua_pushinteger(L, stats->cycles);
+  lua_setfield(L, -2, "idle_cycles");
+  lua_pushnumber(L, stats->step_time / 1000.0);
+  lua_setfield(L, -2, "idle_time");
+  lua_pushinteger(L, stats->fulls);
+  lua_setfield(L, -2, "full_collections");
+  lua_pushnumber(L, stats->full_time / 1000.0);
+  lua_setfield(L, -2, "full_time");
+  lua_pushnumber(L, (stats->step_time + stats->full_time) / 1000.0);
+  lua_setfield(L, -2, "time");
+  lua_pushnumber(L, stats->max_pause / 1000.0);
+  lua_setfield(L, -2, "max_pause");
+  return 1;
+}
+
 static int builtin_put(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
@@ -463,6 +659,13 @@ static int builtin_copy(lua_State* L)
   return 0;
 }
 
+static void copy_to_secondary(Context* context, const char* text, void* user_data)
+{
+  if (text) {
+    gtk_clipboard_set_text(gtk_clipboard_get(GDK_SELECTION_SECONDARY), text, -1);
+  }
+}
+
 static int builtin_copy_selection(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
@@ -482,14 +685,23 @@ static int builtin_copy_selection(lua_State* L)
     return 0;
   }
 
-  GtkClipboard* pri = gtk_clipboard_get(GDK_SELECTION_PRIMARY);
-  char* text = gtk_clipboard_wait_for_text(pri);
-  GtkClipboard* sec = gtk_clipboard_get(GDK_SELECTION_SECONDARY);
-  gtk_clipboard_set_text(sec, text, -1);
+#ifdef TYM_USE_VTE_GET_TEXT_SELECTED
+  char* text = vte_terminal_get_text_selected(context->layout.vte, VTE_FORMAT_TEXT);
+  copy_to_secondary(context, text, NULL);
   g_free(text);
+#else
+  context_request_text(context, GDK_SELECTION_PRIMARY, copy_to_secondary, NULL, NULL);
+#endif
   return 0;
 }
 
+static void paste_text(Context* context, const char* text, void* user_data)
+{
+  if (text) {
+    vte_terminal_feed_child(context->layout.vte, text, -1);
+  }
+}
+
 static int builtin_paste(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
@@ -508,10 +720,7 @@ static int builtin_paste(lua_State* L)
     luaX_warn(L, "Invalid target(`%s`): 'clipboard', 'primary' or 'secondary' is available.", target);
     return 0;
   }
-  GtkClipboard* cb = gtk_clipboard_get(selection);
-  char* text = gtk_clipboard_wait_for_text(cb);
-  vte_terminal_feed_child(context->layout.vte, text, -1);
-  g_free(text);
+  context_request_text(context, selection, paste_text, NULL, NULL);
   return 0;
 }
 
@@ -578,35 +787,143 @@ static int builtin_get_cursor_position(lua_State* L)
   return 2;
 }
 
-static int builtin_get_clipboard(lua_State* L)
+static bool check_clipboard_target(lua_State* L, int index, GdkAtom* selection)
 {
-  const char* target = lua_tostring(L, 1);
-  GdkAtom selection = GDK_SELECTION_CLIPBOARD;
+  const char* target = lua_tostring(L, index);
+  *selection = GDK_SELECTION_CLIPBOARD;
   if (!target || is_equal(target, TYM_CLIPBOARD_CLIPBOARD)) {
   } else if (is_equal(target, TYM_CLIPBOARD_PRIMARY)) {
-    selection = GDK_SELECTION_PRIMARY;
+    *selection = GDK_SELECTION_PRIMARY;
   } else if (is_equal(target, TYM_CLIPBOARD_SECONDARY)) {
-    selection = GDK_SELECTION_SECONDARY;
+    *selection = GDK_SELECTION_SECONDARY;
   } else {
     luaX_warn(L, "Invalid target(`%s`): 'clipboard', 'primary' or 'secondary' is available.", target);
+    return false;
+  }
+  return true;
+}
+
+// `user_data` is the ref of the Lua function to receive the text.
+static void call_text_callback(Context* context, const char* text, void* user_data)
+{
+  lua_State* L = context->lua;
+  int ref = GPOINTER_TO_INT(user_data);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+  luaL_unref(L, LUA_REGISTRYINDEX, ref);
+  lua_pushstring(L, text);
+  memory_enter(L);
+  int status = lua_pcall(L, 1, 0, 0);
+  memory_leave(L);
+  if (status != LUA_OK) {
+    luaX_warn(L, "Error in clipboard callback: '%s'", lua_tostring(L, -1));
+    lua_pop(L, 1); // error
+  }
+}
+
+static void release_text_callback(Context* context, void* user_data)
+{
+  luaL_unref(context->lua, LUA_REGISTRYINDEX, GPOINTER_TO_INT(user_data));
+}
+
+static void resume_with_text(Context* context, const char* text, void* user_data)
+{
+  CoroWait* wait = (CoroWait*)user_data;
+  lua_pushstring(wait->co, text);
+  coro_wait_resume(wait, 1);
+}
+
+// In hooks, keymaps and timeouts, suspends the caller instead of spinning a nested main loop.
+static int builtin_get_clipboard(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  GdkAtom selection;
+  if (!check_clipboard_target(L, 1, &selection)) {
     return 0;
   }
-  GtkClipboard* cb = gtk_clipboard_get(selection);
-  char* text = gtk_clipboard_wait_for_text(cb);
+  if (coro_is_managed(L)) {
+    context_request_text(context, selection, resume_with_text, NULL, coro_wait_new(L));
+    return lua_yield(L, 0);
+  }
+  char* text = context_wait_for_text(context, selection);
   lua_pushstring(L, text);
   g_free(text);
   return 1;
 }
 
+// Without `func`, suspends the calling coroutine and returns the text.
+static int builtin_get_clipboard_async(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  bool await = lua_isnoneornil(L, 2);
+  luaL_argcheck(L, await || lua_isfunction(L, 2), 2, "function expected");
+  if (await && !coro_is_managed(L)) {
+    return luaL_error(L, "func is required outside hooks, keymaps and timeouts");
+  }
+  GdkAtom selection;
+  if (!check_clipboard_target(L, 1, &selection)) {
+    return 0;
+  }
+  if (await) {
+    context_request_text(context, selection, resume_with_text, NULL, coro_wait_new(L));
+    return lua_yield(L, 0);
+  }
+  lua_pushvalue(L, 2);
+  int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  context_request_text(context, selection, call_text_callback, release_text_callback, GINT_TO_POINTER(ref));
+  return 0;
+}
+
 static int builtin_get_selection(lua_State* L)
 {
-  GtkClipboard* cb = gtk_clipboard_get(GDK_SELECTION_PRIMARY);
-  char* text = gtk_clipboard_wait_for_text(cb);
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+#ifdef TYM_USE_VTE_GET_TEXT_SELECTED
+  char* text = vte_terminal_get_text_selected(context->layout.vte, VTE_FORMAT_TEXT);
+#else
+  if (coro_is_managed(L)) {
+    context_request_text(context, GDK_SELECTION_PRIMARY, resume_with_text, NULL, coro_wait_new(L));
+    return lua_yield(L, 0);
+  }
+  char* text = context_wait_for_text(context, GDK_SELECTION_PRIMARY);
+#endif
   lua_pushstring(L, text);
   g_free(text);
   return 1;
 }
 
+static int builtin_get_selection_async(lua_State* L)
+{
+  Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
+  bool await = lua_isnoneornil(L, 1);
+  luaL_argcheck(L, await || lua_isfunction(L, 1), 1, "function expected");
+  if (await && !coro_is_managed(L)) {
+    return luaL_error(L, "func is required outside hooks, keymaps and timeouts");
+  }
+#ifdef TYM_USE_VTE_GET_TEXT_SELECTED
+  if (await) {
+    // available at once
+    char* text = vte_terminal_get_text_selected(context->layout.vte, VTE_FORMAT_TEXT);
+    lua_pushstring(L, text);
+    g_free(text);
+    return 1;
+  }
+#else
+  if (await) {
+    context_request_text(context, GDK_SELECTION_PRIMARY, resume_with_text, NULL, coro_wait_new(L));
+    return lua_yield(L, 0);
+  }
+#endif
+  lua_pushvalue(L, 1);
+  int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+#ifdef TYM_USE_VTE_GET_TEXT_SELECTED
+  char* text = vte_terminal_get_text_selected(context->layout.vte, VTE_FORMAT_TEXT);
+  call_text_callback(context, text, GINT_TO_POINTER(ref));
+  g_free(text);
+#else
+  context_request_text(context, GDK_SELECTION_PRIMARY, call_text_callback, release_text_callback, GINT_TO_POINTER(ref));
+#endif
+  return 0;
+}
+
 static int builtin_get_text(lua_State* L)
 {
   Context* context = (Context*)lua_touserdata(L, lua_upvalueindex(1));
@@ -682,17 +999,30 @@ int builtin_register_module(lua_State* L)
     { "get_config"          , builtin_get_config           },
     { "set_config"          , builtin_set_config           },
     { "reset_config"        , builtin_reset_config         },
+    { "set_palette"         , builtin_set_palette          },
+    { "batch"               , builtin_batch                },
     { "set_keymap"          , builtin_set_keymap           },
     { "unset_keymap"        , builtin_unset_keymap         },
     { "set_keymaps"         , builtin_set_keymaps          },
     { "reset_keymaps"       , builtin_reset_keymaps        },
+    { "set_mode"            , builtin_set_mode             },
+    { "get_mode"            , builtin_get_mode             },
     { "set_hook"            , builtin_set_hook             },
     { "set_hooks"           , builtin_set_hooks            },
+    { "add_hook"            , builtin_add_hook             },
+    { "remove_hook"         , builtin_remove_hook          },
     { "reload"              , builtin_reload               },
     { "reload_theme"        , builtin_reload_theme         },
     { "send_key"            , builtin_send_key             },
     { "set_timeout"         , builtin_set_timeout          },
     { "clear_timeout"       , builtin_clear_timeout        },
+    { "set_interval"        , builtin_set_interval         },
+    { "clear_interval"      , builtin_clear_timeout        },
+    { "sleep"               , builtin_sleep                },
+    { "defer"               , builtin_defer                },
+    { "set_budget"          , builtin_set_budget           },
+    { "get_memory_stats"    , builtin_get_memory_stats     },
+    { "gc_stats"            , builtin_gc_stats             },
     { "put"                 , builtin_put                  },
     { "bell"                , builtin_bell                 },
     { "open"                , builtin_open                 },
@@ -707,7 +1037,9 @@ int builtin_register_module(lua_State* L)
     { "get_monitor_model"   , builtin_get_monitor_model    },
     { "get_cursor_position" , builtin_get_cursor_position  },
     { "get_clipboard"       , builtin_get_clipboard        },
+    { "get_clipboard_async" , builtin_get_clipboard_async  },
     { "get_selection"       , builtin_get_selection        },
+    { "get_selection_async" , builtin_get_selection_async  },
     { "get_text"            , builtin_get_text             },
     { "get_config_path"     , builtin_get_config_path      },
     { "get_theme_path"      , builtin_get_theme_path       },
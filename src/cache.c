@@ -0,0 +1,194 @@
+/**
+ * cache.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include <glib/gstdio.h>
+#include "cache.h"
+
+
+#define TYM_CACHE_MAGIC "TYMC"
+#define TYM_CACHE_FILE_EXT ".luac"
+
+typedef struct {
+  char magic[4];
+  int lua_version;
+  gint64 size;
+  gint64 mtime;
+} CacheHeader;
+
+
+static char* cache_acquire_path(const char* path)
+{
+  char* hash = g_compute_checksum_for_string(G_CHECKSUM_SHA1, path, -1);
+  char* name = g_strconcat(hash, TYM_CACHE_FILE_EXT, NULL);
+  char* cache_path = g_build_path(
+    G_DIR_SEPARATOR_S,
+    g_get_user_cache_dir(),
+    TYM_CONFIG_DIR_NAME,
+    name,
+    NULL
+  );
+  g_free(name);
+  g_free(hash);
+  return cache_path;
+}
+
+static int cache_writer(lua_State* L, const void* p, size_t size, void* user_data)
+{
+  g_byte_array_append((GByteArray*)user_data, p, size);
+  return 0;
+}
+
+static void cache_store(lua_State* L, const char* cache_path, CacheHeader* header)
+{
+  GByteArray* buf = g_byte_array_new();
+  g_byte_array_append(buf, (guint8*)header, sizeof(CacheHeader));
+  // keep debug info so that error messages still point to the source
+  lua_dump(L, cache_writer, buf, false);
+
+  char* dir = g_path_get_dirname(cache_path);
+  GError* error = NULL;
+  if (g_mkdir_with_parents(dir, 0700) != 0) {
+    dd("could not create cache dir: `%s`", dir);
+  } else if (!g_file_set_contents(cache_path, (char*)buf->data, buf->len, &error)) {
+    dd("could not write cache: %s", error->message);
+    g_error_free(error);
+  }
+  g_free(dir);
+  g_byte_array_unref(buf);
+}
+
+int cache_load_file(lua_State* L, const char* path)
+{
+  // `st_mtim` is not visible under `-std=c11`, so the sub-second part of the mtime is read through GIO.
+  // Whole seconds would return stale bytecode for an edit which keeps the size in the same second.
+  GFile* file = g_file_new_for_path(path);
+  GFileInfo* info = g_file_query_info(
+    file,
+    G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+    G_FILE_QUERY_INFO_NONE,
+    NULL,
+    NULL
+  );
+  g_object_unref(file);
+  if (!info) {
+    return luaL_loadfile(L, path);
+  }
+  // zero-filled so that the padding can be compared as well
+  CacheHeader header;
+  memset(&header, 0, sizeof(CacheHeader));
+  memcpy(header.magic, TYM_CACHE_MAGIC, sizeof(header.magic));
+  header.lua_version = LUA_VERSION_NUM;
+  header.size = g_file_info_get_size(info);
+  header.mtime = (gint64)g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+    + g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  g_object_unref(info);
+
+  char* cache_path = cache_acquire_path(path);
+  char* chunkname = g_strconcat("@", path, NULL);
+  int result = LUA_ERRFILE;
+
+  GMappedFile* mapped = g_mapped_file_new(cache_path, false, NULL);
+  if (mapped) {
+    size_t length = g_mapped_file_get_length(mapped);
+    const char* data = g_mapped_file_get_contents(mapped);
+    if (length > sizeof(CacheHeader) && memcmp(data, &header, sizeof(CacheHeader)) == 0) {
+      result = luaL_loadbufferx(L, data + sizeof(CacheHeader), length - sizeof(CacheHeader), chunkname, "b");
+      if (result != LUA_OK) {
+        dd("broken cache for `%s`: %s", path, lua_tostring(L, -1));
+        lua_pop(L, 1);
+      }
+    }
+    g_mapped_file_unref(mapped);
+  }
+
+  if (result != LUA_OK) {
+    dd("compile `%s`", path);
+    result = luaL_loadfile(L, path);
+    if (result == LUA_OK) {
+      cache_store(L, cache_path, &header);
+    }
+  }
+  g_free(chunkname);
+  g_free(cache_path);
+  return result;
+}
+
+// Prefixes the relative templates of `package.path` with `cwd`, since `package.searchpath()` opens them
+// relative to the cwd of the process, which is not the one of the client in a daemon window.
+static void cache_push_path(lua_State* L, const char* cwd)
+{
+  lua_getfield(L, lua_upvalueindex(1), "path");
+  const char* path = lua_tostring(L, -1);
+  if (!cwd || !path) {
+    return;
+  }
+  luaL_Buffer b;
+  luaL_buffinit(L, &b);
+  char** templates = g_strsplit(path, ";", -1);
+  for (unsigned i = 0; templates[i]; i++) {
+    if (i > 0) {
+      luaL_addchar(&b, ';');
+    }
+    if (!is_empty(templates[i]) && !g_path_is_absolute(templates[i])) {
+      luaL_addstring(&b, cwd);
+      luaL_addstring(&b, G_DIR_SEPARATOR_S);
+    }
+    luaL_addstring(&b, templates[i]);
+  }
+  g_strfreev(templates);
+  luaL_pushresult(&b);
+  lua_remove(L, -2);
+}
+
+static int cache_searcher(lua_State* L)
+{
+  const char* name = luaL_checkstring(L, 1);
+  const char* cwd = lua_tostring(L, lua_upvalueindex(2));
+  lua_getfield(L, lua_upvalueindex(1), "searchpath");
+  lua_pushstring(L, name);
+  cache_push_path(L, cwd);
+  lua_call(L, 2, 2);
+  if (lua_isnil(L, -2)) {
+    return 1; // message why not found
+  }
+  const char* filename = lua_tostring(L, -2);
+  char* path;
+  if (g_path_is_absolute(filename)) {
+    path = g_strdup(filename);
+  } else {
+    char* dir = cwd ? g_strdup(cwd) : g_get_current_dir();
+    path = g_build_path(G_DIR_SEPARATOR_S, dir, filename, NULL);
+    g_free(dir);
+  }
+  int result = cache_load_file(L, path);
+  g_free(path);
+  if (result != LUA_OK) {
+    return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s", name, filename, lua_tostring(L, -1));
+  }
+  lua_pushvalue(L, -3); // filename as the second argument of the loader
+  return 2;
+}
+
+// `cwd` is the directory which relative module paths are resolved against, NULL for the one of the process.
+void cache_register_searcher(lua_State* L, const char* cwd)
+{
+  luaL_getsubtable(L, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+  lua_getfield(L, -1, LUA_LOADLIBNAME);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 2);
+    return;
+  }
+  lua_getfield(L, -1, "searchers");
+  // replace the Lua file searcher (the second one) with the cached one
+  lua_pushvalue(L, -2);
+  lua_pushstring(L, cwd);
+  lua_pushcclosure(L, cache_searcher, 2);
+  lua_rawseti(L, -2, 2);
+  lua_pop(L, 3);
+}
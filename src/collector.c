@@ -0,0 +1,179 @@
+/**
+ * collector.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "collector.h"
+
+
+Collector* collector_init(lua_State* L)
+{
+  Collector* collector = g_malloc0(sizeof(Collector));
+  collector->L = L;
+  collector->last_input = g_get_monotonic_time();
+  // setting returns the previous value, which is put back
+  collector->default_pause = lua_gc(L, LUA_GCSETPAUSE, 0);
+  lua_gc(L, LUA_GCSETPAUSE, collector->default_pause);
+  collector->default_stepmul = lua_gc(L, LUA_GCSETSTEPMUL, 0);
+  lua_gc(L, LUA_GCSETSTEPMUL, collector->default_stepmul);
+  return collector;
+}
+
+// Must be called before `lua_close()`.
+void collector_close(Collector* collector)
+{
+  if (collector->wake_tag) {
+    g_source_remove(collector->wake_tag);
+  }
+  if (collector->step_tag) {
+    g_source_remove(collector->step_tag);
+  }
+  g_free(collector);
+}
+
+// Finalizers can raise errors, so the collector is run in a protected call.
+static int collector_step(lua_State* L)
+{
+  lua_pushboolean(L, lua_gc(L, LUA_GCSTEP, 0));
+  return 1;
+}
+
+static int collector_full(lua_State* L)
+{
+  lua_gc(L, LUA_GCCOLLECT, 0);
+  return 0;
+}
+
+static bool collector_call(Collector* collector, lua_CFunction func, int nresult)
+{
+  lua_State* L = collector->L;
+  lua_pushcfunction(L, func);
+  if (lua_pcall(L, 0, nresult, 0) != LUA_OK) {
+    luaX_warn(L, "Error in garbage collection: '%s'", lua_tostring(L, -1));
+    lua_pop(L, 1); // error
+    return false;
+  }
+  return true;
+}
+
+static void collector_record(Collector* collector, gint64 elapsed, gint64* total)
+{
+  *total += elapsed;
+  if (elapsed > collector->stats.max_pause) {
+    collector->stats.max_pause = elapsed;
+  }
+}
+
+static gboolean on_collector_step(void* user_data)
+{
+  Collector* collector = (Collector*)user_data;
+  gint64 start = g_get_monotonic_time();
+  gint64 now = start;
+  bool finished = false;
+  while (!finished && now - start < COLLECTOR_SLICE_USEC) {
+    if (!collector_call(collector, collector_step, 1)) {
+      finished = true;
+      break;
+    }
+    finished = lua_toboolean(collector->L, -1);
+    lua_pop(collector->L, 1);
+    collector->stats.steps += 1;
+    now = g_get_monotonic_time();
+  }
+  collector_record(collector, now - start, &collector->stats.step_time);
+  if (!finished) {
+    return G_SOURCE_CONTINUE;
+  }
+  // nothing to do until the next input
+  collector->stats.cycles += 1;
+  collector->step_tag = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static void collector_schedule(Collector* collector);
+
+static gboolean on_collector_wake(void* user_data)
+{
+  Collector* collector = (Collector*)user_data;
+  collector->wake_tag = 0;
+  if (g_get_monotonic_time() - collector->last_input < collector->delay) {
+    // input arrived while waiting
+    collector_schedule(collector);
+    return G_SOURCE_REMOVE;
+  }
+  if (!collector->step_tag) {
+    collector->step_tag = g_idle_add_full(G_PRIORITY_LOW, on_collector_step, collector, NULL);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+// Input only moves `last_input`, and the wakeup checks it, so typing does not re-arm the timeout each time.
+static void collector_schedule(Collector* collector)
+{
+  if (collector->wake_tag || !collector->delay) {
+    return;
+  }
+  gint64 delay = collector->last_input + collector->delay - g_get_monotonic_time();
+  collector->wake_tag = g_timeout_add(delay > 0 ? (delay + 999) / 1000 : 0, on_collector_wake, collector);
+}
+
+void collector_set_idle_delay(Collector* collector, int msec)
+{
+  collector->delay = MAX(msec, 0) * (gint64)1000;
+  if (collector->wake_tag) {
+    g_source_remove(collector->wake_tag);
+    collector->wake_tag = 0;
+  }
+  if (!collector->delay && collector->step_tag) {
+    g_source_remove(collector->step_tag);
+    collector->step_tag = 0;
+  }
+  collector_schedule(collector);
+}
+
+// 0 restores the value of Lua.
+void collector_set_params(Collector* collector, int pause, int stepmul)
+{
+  lua_gc(collector->L, LUA_GCSETPAUSE, pause > 0 ? pause : collector->default_pause);
+  lua_gc(collector->L, LUA_GCSETSTEPMUL, stepmul > 0 ? stepmul : collector->default_stepmul);
+}
+
+// Returns false if generational mode is not supported by Lua.
+bool collector_set_generational(Collector* collector, bool generational)
+{
+#ifdef TYM_USE_LUA_GENERATIONAL_GC
+  lua_gc(collector->L, generational ? LUA_GCGEN : LUA_GCINC, 0, 0, 0);
+  collector->generational = generational;
+  return true;
+#else
+  return !generational;
+#endif
+}
+
+// Called on input. The idle steps stop until the input stops for `delay`.
+void collector_touch(Collector* collector)
+{
+  collector->last_input = g_get_monotonic_time();
+  if (collector->step_tag) {
+    g_source_remove(collector->step_tag);
+    collector->step_tag = 0;
+  }
+  collector_schedule(collector);
+}
+
+void collector_collect(Collector* collector)
+{
+  gint64 start = g_get_monotonic_time();
+  collector_call(collector, collector_full, 0);
+  collector_record(collector, g_get_monotonic_time() - start, &collector->stats.full_time);
+  collector->stats.fulls += 1;
+  if (collector->step_tag) {
+    // the cycle is finished
+    g_source_remove(collector->step_tag);
+    collector->step_tag = 0;
+  }
+}
@@ -0,0 +1,63 @@
+/**
+ * collector_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "collector.h"
+
+
+void test_collector()
+{
+  lua_State* L = luaL_newstate();
+  luaL_openlibs(L);
+  Collector* collector = collector_init(L);
+
+  luaL_dostring(L, "for i = 1, 10000 do local t = { i } end");
+  int before = lua_gc(L, LUA_GCCOUNT, 0);
+  collector_set_idle_delay(collector, 1);
+  collector_touch(collector);
+  g_assert_cmpuint(collector->stats.steps, ==, 0);
+
+  gint64 deadline = g_get_monotonic_time() + G_USEC_PER_SEC;
+  while (!collector->stats.cycles && g_get_monotonic_time() < deadline) {
+    g_main_context_iteration(NULL, true);
+  }
+  g_assert_cmpuint(collector->stats.cycles, ==, 1);
+  g_assert_cmpuint(collector->stats.steps, >, 0);
+  g_assert_cmpint(lua_gc(L, LUA_GCCOUNT, 0), <, before);
+
+  // input stops the steps
+  luaL_dostring(L, "for i = 1, 10000 do local t = { i } end");
+  collector_touch(collector);
+  g_assert_cmpuint(collector->step_tag, ==, 0);
+
+  collector_collect(collector);
+  g_assert_cmpuint(collector->stats.fulls, ==, 1);
+  g_assert_cmpint(collector->stats.max_pause, >=, 0);
+
+  // errors in finalizers are caught
+  luaL_dostring(L, "setmetatable({}, { __gc = function() error('boom') end })");
+  collector_collect(collector);
+  g_assert_cmpint(lua_gettop(L), ==, 0);
+
+  collector_set_params(collector, 150, 400);
+  g_assert_cmpint(lua_gc(L, LUA_GCSETPAUSE, 150), ==, 150);
+  collector_set_params(collector, 0, 0);
+  g_assert_cmpint(lua_gc(L, LUA_GCSETSTEPMUL, collector->default_stepmul), ==, collector->default_stepmul);
+
+#ifdef TYM_USE_LUA_GENERATIONAL_GC
+  g_assert_true(collector_set_generational(collector, true));
+#else
+  g_assert_false(collector_set_generational(collector, true));
+#endif
+  g_assert_true(collector_set_generational(collector, false));
+
+  collector_set_idle_delay(collector, 0);
+  collector_close(collector);
+  lua_close(L);
+}
@@ -10,120 +10,165 @@
 #include "config.h"
 
 
-Config* config_init()
+Config* config_init(unsigned size)
 {
   Config* config = g_malloc0(sizeof(Config));
-  config->data = g_hash_table_new_full(
-    g_str_hash,
-    g_str_equal,
-    (GDestroyNotify)g_free,
-    (GDestroyNotify)g_free
-  );
+  config->slots = g_new0(ConfigSlot, size);
+  config->size = size;
   config->locked = true;
   return config;
 }
 
 void config_close(Config* config)
 {
-  g_hash_table_destroy(config->data);
+  for (unsigned i = 0; i < config->size; i++) {
+    g_free(config->slots[i].str);
+  }
+  g_free(config->slots);
   g_free(config);
 }
 
-static void* config_get_raw(Config* config, const char* key)
+static ConfigSlot* config_get_slot(Config* config, unsigned index)
+{
+  if (index >= config->size) {
+    dd("tried to refer invalid index: %u", index);
+    return NULL;
+  }
+  ConfigSlot* slot = &config->slots[index];
+  if (!slot->assigned) {
+    dd("tried to refer null field: %u", index);
+    return NULL;
+  }
+  return slot;
+}
+
+static ConfigSlot* config_prepare_slot(Config* config, unsigned index)
 {
-  void* ptr = g_hash_table_lookup(config->data, key);
-  if (!ptr) {
-    dd("tried to refer null field: '%s'", key);
+  if (index >= config->size) {
+    dd("tried to set invalid index: %u", index);
+    return NULL;
+  }
+  ConfigSlot* slot = &config->slots[index];
+  // warn if: not reseting and attempt to insert value
+  if (config->locked && !slot->assigned) {
+    dd("tried to add new field when locked: %u", index);
+    return NULL;
   }
-  return ptr;
+  slot->assigned = true;
+  return slot;
 }
 
-static void config_set_raw(Config* config, const char* key, void* value)
+void config_set_str(Config* config, unsigned index, const char* value)
 {
   if (!value) {
-    dd("tried to set null field: '%s'", key);
+    dd("tried to set null field: %u", index);
     return;
   }
-  void* old_key = NULL;
-  bool has_value = g_hash_table_lookup_extended(config->data, key, &old_key, NULL);
-  // warn if: not reseting and attempt to insert value
-  if (config->locked && !has_value) {
-    dd("tried to add new field when locked: '%s'", key);
+  ConfigSlot* slot = config_prepare_slot(config, index);
+  if (!slot) {
     return;
   }
-  if (old_key) {
-    g_hash_table_remove(config->data, old_key);
+  char* old = slot->str;
+  slot->str = g_strdup(value);
+  slot->has_color = false;
+  g_free(old);
+}
+
+const GdkRGBA* config_get_color(Config* config, unsigned index)
+{
+  ConfigSlot* slot = config_get_slot(config, index);
+  if (slot && slot->has_color) {
+    return &slot->color;
   }
-  g_hash_table_insert(config->data, g_strdup(key), value);
-  return;
+  return NULL;
 }
 
-void config_set_str(Config* config, const char* key, const char* value)
+// Store the string and its parsed color. Returns false and stores no color if the value is not a
+// color (like `NONE` or empty), but the string is stored anyway.
+bool config_set_color(Config* config, unsigned index, const char* value)
 {
-  config_set_raw(config, key, g_strdup(value));
+  GdkRGBA color = {};
+  bool valid = value && gdk_rgba_parse(&color, value);
+  config_set_str(config, index, value);
+  ConfigSlot* slot = config_get_slot(config, index);
+  if (!slot || !valid) {
+    return false;
+  }
+  slot->color = color;
+  slot->has_color = true;
+  return true;
 }
 
-const char* config_get_str(Config* config, const char* key)
+const char* config_get_str(Config* config, unsigned index)
 {
-  char* v = (char*)config_get_raw(config, key);
-  if (v) {
-    return v;
+  ConfigSlot* slot = config_get_slot(config, index);
+  if (slot && slot->str) {
+    return slot->str;
   }
-  dd("string config of '%s' is null. falling back to \"\"", key);
+  dd("string config of %u is null. falling back to \"\"", index);
   return "";
 }
 
-int config_get_int(Config* config, const char* key)
+int config_get_int(Config* config, unsigned index)
 {
-  int* v = (int*)config_get_raw(config, key);
-  if (v) {
-    return *v;
+  ConfigSlot* slot = config_get_slot(config, index);
+  if (slot) {
+    return slot->integer;
   }
-  dd("int config of '%s' is null. falling back to 0", key);
+  dd("int config of %u is null. falling back to 0", index);
   return 0;
 }
 
-void config_set_int(Config* config, const char* key, int value)
+void config_set_int(Config* config, unsigned index, int value)
 {
-  config_set_raw(config, key, g_memdup((gpointer)&value, sizeof(int)));
+  ConfigSlot* slot = config_prepare_slot(config, index);
+  if (slot) {
+    slot->integer = value;
+  }
 }
 
-bool config_get_bool(Config* config, const char* key)
+bool config_get_bool(Config* config, unsigned index)
 {
-  bool* v = (bool*)config_get_raw(config, key);
-  if (v) {
-    return *v;
+  ConfigSlot* slot = config_get_slot(config, index);
+  if (slot) {
+    return slot->boolean;
   }
-  dd("bool config of '%s' is null. falling back to null", key);
+  dd("bool config of %u is null. falling back to false", index);
   return false;
 }
 
-void config_set_bool(Config* config, const char* key, bool value)
+void config_set_bool(Config* config, unsigned index, bool value)
 {
-  config_set_raw(config, key, g_memdup((gpointer)&value, sizeof(bool)));
+  ConfigSlot* slot = config_prepare_slot(config, index);
+  if (slot) {
+    slot->boolean = value;
+  }
 }
 
 void config_restore_default(Config* config, Meta* meta)
 {
   df();
   config->locked = false;
-  g_hash_table_remove_all(config->data);
+  for (unsigned i = 0; i < config->size; i++) {
+    g_clear_pointer(&config->slots[i].str, g_free);
+    config->slots[i].assigned = false;
+  }
 
-  for (GList* li = meta->list; li != NULL; li = li->next) {
-    MetaEntry* e = (MetaEntry*)li->data;
+  for (unsigned i = 0; i < META_KEY_COUNT; i++) {
+    const MetaEntry* e = &meta->entries[i];
     if (e->getter) {
-      // if getter exists, do not save value in hash
+      // if getter exists, do not save value in slot
       continue;
     }
     switch (e->type) {
       case META_ENTRY_TYPE_STRING:
-        config_set_str(config, e->name, e->default_value);
+        config_set_str(config, e->index, meta->defaults[e->index]);
         break;
       case META_ENTRY_TYPE_INTEGER:
-        config_set_int(config, e->name, *(int*)(e->default_value));
+        config_set_int(config, e->index, *(const int*)meta->defaults[e->index]);
         break;
       case META_ENTRY_TYPE_BOOLEAN:
-        config_set_bool(config, e->name, *(bool*)(e->default_value));
+        config_set_bool(config, e->index, *(const bool*)meta->defaults[e->index]);
         break;
       case META_ENTRY_TYPE_NONE:
         break;
@@ -10,34 +10,64 @@
 #include "tym_test.h"
 #include "config.h"
 
+enum {
+  KEY_INT,
+  KEY_STR,
+  KEY_BOOL,
+  KEY_COLOR,
+  KEY_COUNT,
+};
+
 static void test_read_and_write()
 {
-  Config* c = config_init();
+  Config* c = config_init(KEY_COUNT);
 
   c->locked = false;
-  config_set_int(c, "int", 123);
-  config_set_str(c, "str", "tym");
-  config_set_bool(c, "bool", true);
+  config_set_int(c, KEY_INT, 123);
+  config_set_str(c, KEY_STR, "tym");
+  config_set_bool(c, KEY_BOOL, true);
   c->locked = true;
 
-  g_assert_cmpint(config_get_int(c, "int"), ==, 123);
-  g_assert_cmpstr(config_get_str(c, "str"), ==, "tym");
-  g_assert_cmpuint(config_get_bool(c, "bool"), ==, true);
+  g_assert_cmpint(config_get_int(c, KEY_INT), ==, 123);
+  g_assert_cmpstr(config_get_str(c, KEY_STR), ==, "tym");
+  g_assert_cmpuint(config_get_bool(c, KEY_BOOL), ==, true);
   config_close(c);
 }
 
 static void test_locked()
 {
-  Config* c = config_init();
+  Config* c = config_init(KEY_COUNT);
 
-  config_set_int(c, "int", 123);
-  config_set_str(c, "str", "tym");
-  config_set_bool(c, "bool", true);
+  config_set_int(c, KEY_INT, 123);
+  config_set_str(c, KEY_STR, "tym");
+  config_set_bool(c, KEY_BOOL, true);
 
   // can not save values
-  g_assert_cmpint(config_get_int(c, "int"), ==, 0);
-  g_assert_cmpstr(config_get_str(c, "str"), ==, "");
-  g_assert_cmpuint(config_get_bool(c, "bool"), ==, false);
+  g_assert_cmpint(config_get_int(c, KEY_INT), ==, 0);
+  g_assert_cmpstr(config_get_str(c, KEY_STR), ==, "");
+  g_assert_cmpuint(config_get_bool(c, KEY_BOOL), ==, false);
+  config_close(c);
+}
+
+static void test_color()
+{
+  Config* c = config_init(KEY_COUNT);
+  c->locked = false;
+
+  g_assert_true(config_set_color(c, KEY_COLOR, "#0000ff"));
+  g_assert_cmpstr(config_get_str(c, KEY_COLOR), ==, "#0000ff");
+  const GdkRGBA* color = config_get_color(c, KEY_COLOR);
+  g_assert_nonnull(color);
+  g_assert_cmpfloat(color->blue, ==, 1.0);
+
+  // the string is kept but no color
+  g_assert_false(config_set_color(c, KEY_COLOR, "NONE"));
+  g_assert_cmpstr(config_get_str(c, KEY_COLOR), ==, "NONE");
+  g_assert_null(config_get_color(c, KEY_COLOR));
+
+  config_set_color(c, KEY_COLOR, "red");
+  config_set_str(c, KEY_COLOR, "");
+  g_assert_null(config_get_color(c, KEY_COLOR));
   config_close(c);
 }
 
@@ -45,4 +75,5 @@ void test_config()
 {
   test_read_and_write();
   test_locked();
+  test_color();
 }
@@ -12,6 +12,7 @@
 #include "builtin.h"
 #include "property.h"
 #include "command.h"
+#include "cache.h"
 
 
 typedef void (*TymCommandFunc)(Context* context);
@@ -37,6 +38,8 @@ static KeyPair DEFAULT_KEY_PAIRS[] = {
   {},
 };
 
+static void context_on_error(Context* context, const char* fmt, ...);
+
 static SignalDefinition SIGNALS[] = {
   { "ReloadTheme", command_reload_theme },
   {},
@@ -61,12 +64,23 @@ char* context_acquire_config_path(Context* context)
   if (g_path_is_absolute(path)) {
     return g_strdup(path);
   }
-  char* cwd = g_get_current_dir();
+  char* cwd = context_get_cwd(context);
   path = g_build_path(G_DIR_SEPARATOR_S, cwd, path, NULL);
   g_free(cwd);
   return path;
 }
 
+// A window opened through the daemon behaves like the one started from the shell of the client.
+char* context_get_cwd(Context* context)
+{
+  return context->cwd ? g_strdup(context->cwd) : g_get_current_dir();
+}
+
+char** context_get_environ(Context* context)
+{
+  return context->env ? g_strdupv(context->env) : g_get_environ();
+}
+
 char* context_acquire_theme_path(Context* context)
 {
   char* path = option_get_theme_path(context->option);
@@ -87,23 +101,85 @@ char* context_acquire_theme_path(Context* context)
     return g_strdup(path);
   }
 
-  char* cwd = g_get_current_dir();
+  char* cwd = context_get_cwd(context);
   path = g_build_path(G_DIR_SEPARATOR_S, cwd, path, NULL);
   g_free(cwd);
   return path;
 }
 
+static int context_dofile(Context* context, const char* path)
+{
+  lua_State* L = context->lua;
+  int result = option_get_no_bytecode_cache(context->option)
+    ? luaL_loadfile(L, path)
+    : cache_load_file(L, path);
+  if (result != LUA_OK) {
+    return result;
+  }
+  memory_enter(L);
+  result = lua_pcall(L, 0, LUA_MULTRET, 0);
+  memory_leave(L);
+  return result;
+}
+
+static void on_lua_budget_exceeded(void* user_data, const char* message)
+{
+  context_on_error((Context*)user_data, "%s", message);
+}
+
 void context_load_lua_context(Context* context)
 {
   if (option_get_nolua(context->option)) {
     g_message("Lua context is not loaded");
     return;
   }
-  lua_State* L = luaL_newstate();
+  context->memory = memory_init();
+  memory_set_limit(context->memory, (size_t)config_get_int(context->config, META_KEY_lua_memory_limit) * 1024 * 1024);
+  lua_State* L = memory_new_state(context->memory);
   luaL_openlibs(L);
+  coro_init(L);
+  context->timer = timer_init(L);
+  timer_set_slack(context->timer, config_get_int(context->config, META_KEY_timer_slack));
+  coro_set_error_handler(L, on_lua_budget_exceeded, context);
+  if (!option_get_no_bytecode_cache(context->option)) {
+    cache_register_searcher(L, context->cwd);
+  }
   luaX_requirec(L, TYM_MODULE_NAME, builtin_register_module, true, context);
   lua_pop(L, 1);
   context->lua = L;
+  context->collector = collector_init(L);
+  context_apply_lua_budget(context);
+}
+
+void context_apply_lua_budget(Context* context)
+{
+  if (!context->lua) {
+    return;
+  }
+  coro_set_budget(
+    context->lua,
+    config_get_int(context->config, META_KEY_lua_time_budget),
+    config_get_int(context->config, META_KEY_lua_instruction_budget)
+  );
+}
+
+void context_apply_gc_params(Context* context)
+{
+  if (!context->collector) {
+    return;
+  }
+  collector_set_params(
+    context->collector,
+    config_get_int(context->config, META_KEY_gc_pause),
+    config_get_int(context->config, META_KEY_gc_step_multiplier)
+  );
+}
+
+static void context_load_default_keymap(Context* context)
+{
+  for (unsigned i = 0; DEFAULT_KEY_PAIRS[i].func; i++) {
+    keymap_add_default(context->keymap, DEFAULT_KEY_PAIRS[i].key, DEFAULT_KEY_PAIRS[i].mod, i);
+  }
 }
 
 Context* context_init()
@@ -112,9 +188,12 @@ Context* context_init()
   Context* context = g_malloc0(sizeof(Context));
   context->meta = meta_init();
   context->option = option_init(context->meta);
-  context->config = config_init(context->meta);
+  context->config = config_init(meta_size(context->meta));
   context->keymap = keymap_init();
+  context_load_default_keymap(context);
   context->hook = hook_init();
+  context->palette = palette_init();
+  context->task = task_init();
   context->app = G_APPLICATION(gtk_application_new(
     TYM_APP_ID,
     G_APPLICATION_NON_UNIQUE | G_APPLICATION_HANDLES_COMMAND_LINE)
@@ -122,31 +201,149 @@ Context* context_init()
   return context;
 }
 
+Context* context_init_window(Context* primary)
+{
+  dd("init window");
+  // A window served by the daemon shares the parsed meta and the warm application with the primary context.
+  Context* context = g_malloc0(sizeof(Context));
+  context->primary = primary;
+  context->meta = primary->meta;
+  context->option = option_init(context->meta);
+  context->config = config_init(meta_size(context->meta));
+  context->keymap = keymap_init();
+  context_load_default_keymap(context);
+  context->hook = hook_init();
+  context->palette = palette_init();
+  context->task = task_init();
+  context->app = primary->app;
+  primary->siblings = g_list_append(primary->siblings, context);
+  return context;
+}
+
 void context_close(Context* context)
 {
   dd("close");
-  meta_close(context->meta);
+  while (context->siblings) {
+    context_close((Context*)context->siblings->data);
+  }
+  if (context->state.signal_subscription) {
+    GDBusConnection* conn = g_application_get_dbus_connection(context->app);
+    if (conn) {
+      g_dbus_connection_signal_unsubscribe(conn, context->state.signal_subscription);
+    }
+  }
+  if (context->layout.window) {
+    // the handlers, including the one of `destroy`, must not see this context while it is closed
+    g_signal_handlers_disconnect_by_data(context->layout.vte, context);
+    g_signal_handlers_disconnect_by_data(context->layout.window, context);
+    gtk_widget_destroy(GTK_WIDGET(context->layout.window));
+  }
+  if (context->layout.background_cancellable) {
+    // the pending load finishes without touching this context
+    g_cancellable_cancel(context->layout.background_cancellable);
+    g_object_unref(context->layout.background_cancellable);
+  }
+  g_clear_object(&context->layout.background_pixbuf);
+  g_clear_pointer(&context->layout.background_surface, cairo_surface_destroy);
+  g_free(context->layout.background_path);
+  property_release_uri_regex(context);
+  if (context->coalesce.tag) {
+    g_source_remove(context->coalesce.tag);
+  }
+  if (context->selection.tag) {
+    g_source_remove(context->selection.tag);
+  }
+  if (context->state.close_tag) {
+    g_source_remove(context->state.close_tag);
+  }
+  if (context->state.chord_tag) {
+    g_source_remove(context->state.chord_tag);
+  }
+  for (GList* l = context->clipboard_requests; l; l = l->next) {
+    // freed by the callback which sees the context is gone
+    ClipboardRequest* request = (ClipboardRequest*)l->data;
+    context_cancel_request(request);
+    request->context = NULL;
+  }
+  g_list_free(context->clipboard_requests);
+  g_free(context->cwd);
+  g_strfreev(context->env);
+  // the tick callback went away with the widget
+  g_clear_pointer(&context->scroll.event, gdk_event_free);
+  if (context->profile) {
+    profile_report(context->profile);
+    profile_close(context->profile);
+  }
   option_close(context->option);
   config_close(context->config);
   keymap_close(context->keymap);
   hook_close(context->hook);
-  g_object_unref(context->app);
+  palette_close(context->palette);
+  task_close(context->task);
   if (context->lua) {
+    timer_close(context->timer);
+    collector_close(context->collector);
+    coro_close(context->lua);
     lua_close(context->lua);
+    memory_close(context->memory);
+  }
+  if (context->primary) {
+    context->primary->siblings = g_list_remove(context->primary->siblings, context);
+  } else {
+    meta_close(context->meta);
+    // emptied by the windows which have been closed above
+    g_clear_pointer(&context->uri_regexes, g_hash_table_destroy);
+    g_object_unref(context->app);
   }
   g_free(context);
 }
 
+static gboolean on_close_idle(void* user_data)
+{
+  Context* context = (Context*)user_data;
+  context->state.close_tag = 0;
+  if (context->state.busy) {
+    // scheduled again when the nested loop ends
+    return G_SOURCE_REMOVE;
+  }
+  context_close(context);
+  return G_SOURCE_REMOVE;
+}
+
+// Closes the context from the main loop, since a Lua function of it can be waiting in a nested loop
+// which is dispatching the caller.
+void context_request_close(Context* context)
+{
+  context->state.closing = true;
+  if (!context->state.busy && !context->state.close_tag) {
+    context->state.close_tag = g_idle_add(on_close_idle, context);
+  }
+}
+
 int context_start(Context* context, int argc, char** argv)
 {
   GApplication* app = context->app;
   option_register_entries(context->option, app);
 
+  g_signal_connect(app, "handle-local-options", G_CALLBACK(on_handle_local_options), context);
   g_signal_connect(app, "activate", G_CALLBACK(on_activate), context);
   g_signal_connect(app, "command-line", G_CALLBACK(on_command_line), context);
   return g_application_run(app, argc, argv);
 }
 
+void context_load_profile(Context* context)
+{
+  const char* format = option_get_profile_startup(context->option);
+  if (!format || context->profile) {
+    return;
+  }
+  if (!is_equal(format, TYM_PROFILE_FORMAT_TABLE) && !is_equal(format, TYM_PROFILE_FORMAT_JSON)) {
+    g_message("Invalid profile format (`%s` is provided). '" TYM_PROFILE_FORMAT_TABLE "' or '" TYM_PROFILE_FORMAT_JSON "' is available.", format);
+    return;
+  }
+  context->profile = profile_init(format);
+}
+
 void context_load_device(Context* context)
 {
   GdkDisplay* display = gdk_display_get_default();
@@ -178,55 +375,67 @@ static void context_on_error(Context* context, const char* fmt, ...)
   g_free(message);
 }
 
+// Setters of the properties which are costly to apply (font, scale, size and palette) only
+// record them while batching, and they are applied at once when the outermost batch ends.
+void context_begin_batch(Context* context)
+{
+  context->batch.depth += 1;
+}
+
+void context_end_batch(Context* context)
+{
+  assert(context->batch.depth > 0);
+  context->batch.depth -= 1;
+  if (context->batch.depth == 0) {
+    property_commit_batch(context);
+  }
+}
+
 void context_restore_default(Context* context)
 {
-  config_restore_default(context->config, context->meta);
-  for (GList* li = context->meta->list; li != NULL; li = li->next) {
-    MetaEntry* e = (MetaEntry*)li->data;
-    char* target = NULL;
-    if (strncmp("color_", e->name, 6) == 0) {
-      g_ascii_strtoull(&e->name[6], &target, 10);
-      if (&e->name[6] != target) {
-        // skip loading `color_%d` in this loop
-        continue;
-      }
+  Meta* meta = context->meta;
+  context_begin_batch(context);
+  config_restore_default(context->config, meta);
+  for (unsigned i = 0; i < meta_size(meta); i++) {
+    const MetaEntry* e = &meta->entries[i];
+    if (META_KEY_color_0 <= e->index && e->index <= META_KEY_color_15) {
+      // skip loading `color_%d` in this loop
+      continue;
+    }
+    if (e->type == META_ENTRY_TYPE_NONE) {
+      continue;
     }
-    char* key = e->name;
+    const char* key = e->name;
+    const void* default_value = meta->defaults[e->index];
     switch (e->type) {
       case META_ENTRY_TYPE_STRING: {
-        context_set_str(context, key, e->default_value);
+        context_set_str(context, key, default_value);
         break;
       }
       case META_ENTRY_TYPE_INTEGER: {
-        context_set_int(context, key, *(int*)e->default_value);
+        context_set_int(context, key, *(const int*)default_value);
         break;
       }
       case META_ENTRY_TYPE_BOOLEAN: {
-        context_set_bool(context, key, *(bool*)e->default_value);
+        context_set_bool(context, key, *(const bool*)default_value);
         break;
       }
       case META_ENTRY_TYPE_NONE:
         break;
     }
   }
-  // set colors here
-  GdkRGBA* palette = g_new0(GdkRGBA, 16);
-  unsigned i = 0;
-  while (i < 16) {
-    char s[10] = {};
-    g_snprintf(s, 10, "color_%d", i);
-    MetaEntry* e = meta_get_entry(context->meta, s);
-    assert(gdk_rgba_parse(&palette[i], e->default_value));
-    i += 1;
+  for (unsigned i = 0; i < PALETTE_SIZE; i++) {
+    palette_set_color(context->palette, i, meta->defaults[META_KEY_color_0 + i]);
   }
-  vte_terminal_set_colors(context->layout.vte, NULL, NULL, palette, 16);
+  context->batch.palette = true;
+  context_end_batch(context);
 }
 
 void context_override_by_option(Context* context)
 {
-  for (GList* li = context->meta->list; li != NULL; li = li->next) {
-    MetaEntry* e = (MetaEntry*)li->data;
-    char* key = e->name;
+  for (unsigned i = 0; i < meta_size(context->meta); i++) {
+    const MetaEntry* e = &context->meta->entries[i];
+    const char* key = e->name;
     switch (e->type) {
       case META_ENTRY_TYPE_STRING: {
         const char* v = NULL;
@@ -272,6 +481,7 @@ void context_load_config(Context* context)
   }
 
   context->state.config_loading = true;
+  context_begin_batch(context);
 
   char* config_path = context_acquire_config_path(context);
   dd("config path: `%s`", config_path);
@@ -286,7 +496,9 @@ void context_load_config(Context* context)
   }
 
   lua_State* L = context->lua;
-  int result = luaL_dofile(L, config_path);
+  MemoryPhase phase = memory_set_phase(L, MEMORY_PHASE_CONFIG);
+  int result = context_dofile(context, config_path);
+  memory_set_phase(L, phase);
   if (result != LUA_OK) {
     const char* error = lua_tostring(L, -1);
     lua_pop(L, 1);
@@ -295,6 +507,7 @@ void context_load_config(Context* context)
   }
 
 EXIT:
+  context_end_batch(context);
   context->state.config_loading = false;
   if (config_path) {
     g_free(config_path);
@@ -324,7 +537,9 @@ void context_load_theme(Context* context)
   }
 
   lua_State* L = context->lua;
-  int result = luaL_dofile(L, theme_path);
+  MemoryPhase phase = memory_set_phase(L, MEMORY_PHASE_THEME);
+  int result = context_dofile(context, theme_path);
+  memory_set_phase(L, phase);
   if (result != LUA_OK) {
     const char* error = lua_tostring(L, -1);
     context_on_error(context, error);
@@ -339,8 +554,9 @@ void context_load_theme(Context* context)
     goto EXIT;
   }
 
-  for (GList* li = context->meta->list; li != NULL; li = li->next) {
-    MetaEntry* e = (MetaEntry*)li->data;
+  context_begin_batch(context);
+  for (unsigned i = 0; i < meta_size(context->meta); i++) {
+    const MetaEntry* e = &context->meta->entries[i];
     if (!e->is_theme) {
       continue;
     }
@@ -352,6 +568,7 @@ void context_load_theme(Context* context)
     lua_pop(L, 1);
   }
   lua_pop(L, 1);
+  context_end_batch(context);
 
 EXIT:
   if (theme_path) {
@@ -360,26 +577,14 @@ EXIT:
   dd("load theme end");
 }
 
-static bool context_perform_default(Context* context, unsigned key, GdkModifierType mod)
-{
-  unsigned i = 0;
-  while (DEFAULT_KEY_PAIRS[i].func) {
-    KeyPair* pair = &DEFAULT_KEY_PAIRS[i];
-    if ((key == pair->key) && !(~mod & pair->mod)) {
-      pair->func(context);
-      return true;
-    }
-    i++;
-  }
-  return false;
-}
-
-bool context_perform_keymap(Context* context, unsigned key, GdkModifierType mod)
+// `binding` is a copy, since the keymap func can modify the keymap.
+static bool context_perform_binding(Context* context, const KeymapBinding* binding)
 {
+  int default_id = context->keymap->ignore_default ? -1 : binding->default_id;
   if (context->lua) {
     bool result = false;
     char* error = NULL;
-    if (keymap_perform(context->keymap, context->lua, key, mod, &result, &error)) {
+    if (keymap_perform(context->keymap, context->lua, binding, &result, &error)) {
       // if the keymap func is normally excuted,  default action will be canceled.
       // if `return true` in the keymap func, default action will be performed.
       if (!result) {
@@ -394,10 +599,52 @@ bool context_perform_keymap(Context* context, unsigned key, GdkModifierType mod)
       }
     }
   }
-  if (context_get_bool(context, "ignore_default_keymap")) {
+  if (default_id < 0) {
     return false;
   }
-  return context_perform_default(context, key, mod);
+  DEFAULT_KEY_PAIRS[default_id].func(context);
+  return true;
+}
+
+static gboolean on_chord_timeout(void* user_data)
+{
+  Context* context = (Context*)user_data;
+  context->state.chord_tag = 0;
+  const KeymapBinding* prefix = keymap_expire(context->keymap);
+  if (prefix) {
+    KeymapBinding binding = *prefix;
+    context_perform_binding(context, &binding);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+bool context_perform_keymap(Context* context, unsigned key, GdkModifierType mod)
+{
+  if (context->state.chord_tag) {
+    g_source_remove(context->state.chord_tag);
+    context->state.chord_tag = 0;
+  }
+  bool pending = false;
+  const KeymapBinding* prefix = NULL;
+  const KeymapBinding* found = keymap_lookup(context->keymap, key, mod, &pending, &prefix);
+  KeymapBinding binding = found ? *found : (KeymapBinding){ 0 };
+  if (prefix) {
+    // the chord is not continued, so the prefix acts alone
+    KeymapBinding copy = *prefix;
+    context_perform_binding(context, &copy);
+  }
+  if (pending) {
+    unsigned timeout = context->keymap->timeout;
+    if (timeout && keymap_get_pending(context->keymap)) {
+      context->state.chord_tag = g_timeout_add(timeout, on_chord_timeout, context);
+    }
+    // wait for the rest of the chord
+    return true;
+  }
+  if (!found) {
+    return prefix != NULL;
+  }
+  return context_perform_binding(context, &binding);
 }
 
 void context_handle_signal(Context* context, const char* signal_name, GVariant* parameters)
@@ -465,6 +712,90 @@ void context_launch_uri(Context* context, const char* uri)
   }
 }
 
+static void on_clipboard_text_received(GtkClipboard* cb, const char* text, void* user_data)
+{
+  ClipboardRequest* request = (ClipboardRequest*)user_data;
+  Context* context = request->context;
+  if (context) {
+    context->clipboard_requests = g_list_remove(context->clipboard_requests, request);
+    if (request->func) {
+      request->func(context, text, request->user_data);
+    }
+  }
+  g_free(request);
+}
+
+// `func` is called on the main loop once the text arrives, unless the request is cancelled or
+// the context is closed first. The request must not be touched after `func` is called.
+ClipboardRequest* context_request_text(Context* context, GdkAtom selection, ClipboardFunc func, ClipboardReleaseFunc release, void* user_data)
+{
+  ClipboardRequest* request = g_new0(ClipboardRequest, 1);
+  request->context = context;
+  request->func = func;
+  request->release = release;
+  request->user_data = user_data;
+  context->clipboard_requests = g_list_prepend(context->clipboard_requests, request);
+  gtk_clipboard_request_text(gtk_clipboard_get(selection), on_clipboard_text_received, request);
+  return request;
+}
+
+void context_cancel_request(ClipboardRequest* request)
+{
+  if (request->func && request->release) {
+    request->release(request->context, request->user_data);
+  }
+  request->func = NULL;
+}
+
+typedef struct {
+  bool done;
+  bool timed_out;
+  char* text;
+} ClipboardWait;
+
+static void on_wait_text_received(Context* context, const char* text, void* user_data)
+{
+  ClipboardWait* wait = (ClipboardWait*)user_data;
+  wait->text = g_strdup(text);
+  wait->done = true;
+}
+
+static gboolean on_wait_timeout(void* user_data)
+{
+  ((ClipboardWait*)user_data)->timed_out = true;
+  return G_SOURCE_REMOVE;
+}
+
+// Unlike `gtk_clipboard_wait_for_text()`, gives up after TYM_CLIPBOARD_TIMEOUT when the owner does not answer.
+char* context_wait_for_text(Context* context, GdkAtom selection)
+{
+  ClipboardWait wait = { false, false, NULL };
+  ClipboardRequest* request = context_request_text(context, selection, on_wait_text_received, NULL, &wait);
+  unsigned tag = g_timeout_add(TYM_CLIPBOARD_TIMEOUT, on_wait_timeout, &wait);
+  unsigned depth = context->lua ? memory_suspend(context->lua) : 0;
+  // keeps the context alive while the loop dispatches whatever closes it
+  context->state.busy += 1;
+  while (!wait.done && !wait.timed_out) {
+    g_main_context_iteration(NULL, true);
+  }
+  context->state.busy -= 1;
+  if (context->lua) {
+    memory_restore(context->lua, depth);
+  }
+  if (context->state.closing) {
+    context_request_close(context);
+  }
+  if (wait.done) {
+    if (!wait.timed_out) {
+      g_source_remove(tag);
+    }
+  } else {
+    g_message("Timed out reading the clipboard.");
+    context_cancel_request(request);
+  }
+  return wait.text;
+}
+
 GdkWindow* context_get_gdk_window(Context* context)
 {
   return gtk_widget_get_window(GTK_WIDGET(context->layout.window));
@@ -472,40 +803,40 @@ GdkWindow* context_get_gdk_window(Context* context)
 
 const char* context_get_str(Context* context, const char* key)
 {
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (e->getter) {
     return ((PropertyStrGetter)e->getter)(context, key);
   }
-  return config_get_str(context->config, key);
+  return config_get_str(context->config, e->index);
 }
 
 int context_get_int(Context* context, const char* key)
 {
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (e->getter) {
     return ((PropertyIntGetter)e->getter)(context, key);
   }
-  return config_get_int(context->config, key);
+  return config_get_int(context->config, e->index);
 }
 
 bool context_get_bool(Context* context, const char* key)
 {
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (e->getter) {
     return ((PropertyBoolGetter)e->getter)(context, key);
   }
-  return config_get_bool(context->config, key);
+  return config_get_bool(context->config, e->index);
 }
 
 void context_set_str(Context* context, const char* key, const char* value)
 {
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (e->setter) {
     ((PropertyStrSetter)e->setter)(context, key, value);
     return;
   }
   if (!e->getter) {
-    config_set_str(context->config, key, value);
+    config_set_str(context->config, e->index, value);
     return;
   }
   dd("`%s`: setter is not provided but getter is provided", key);
@@ -513,13 +844,13 @@ void context_set_str(Context* context, const char* key, const char* value)
 
 void context_set_int(Context* context, const char* key, int value)
 {
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (e->setter) {
     ((PropertyIntSetter)e->setter)(context, key, value);
     return;
   }
   if (!e->getter) {
-    config_set_int(context->config, key, value);
+    config_set_int(context->config, e->index, value);
     return;
   }
   dd("`%s`: setter is not provided but getter is provided", key);
@@ -527,13 +858,13 @@ void context_set_int(Context* context, const char* key, int value)
 
 void context_set_bool(Context* context, const char* key, bool value)
 {
-  MetaEntry* e = meta_get_entry(context->meta, key);
+  const MetaEntry* e = meta_get_entry(context->meta, key);
   if (e->setter) {
     ((PropertyBoolSetter)e->setter)(context, key, value);
     return;
   }
   if (!e->getter) {
-    config_set_bool(context->config, key, value);
+    config_set_bool(context->config, e->index, value);
     return;
   }
   dd("`%s`: setter is not provided but getter is provided", key);
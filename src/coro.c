@@ -0,0 +1,271 @@
+/**
+ * coro.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "coro.h"
+
+
+static const char CORO_KEY = 0;
+static const char BUDGET_KEY = 0;
+
+// The extra space of threads started by `coro_run()` points the Coro, and the one of the main thread
+// and the threads made in Lua is NULL since new threads copy it from the main thread.
+static Coro** coro_extra(lua_State* L)
+{
+  return (Coro**)lua_getextraspace(L);
+}
+
+static Coro* coro_get(lua_State* L)
+{
+  lua_rawgetp(L, LUA_REGISTRYINDEX, &CORO_KEY);
+  Coro* coro = (Coro*)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+  return coro;
+}
+
+void coro_init(lua_State* L)
+{
+  Coro* coro = g_malloc0(sizeof(Coro));
+  *coro_extra(L) = NULL;
+  lua_pushlightuserdata(L, coro);
+  lua_rawsetp(L, LUA_REGISTRYINDEX, &CORO_KEY);
+}
+
+// Must be called before `lua_close()`. Suspended coroutines are dropped.
+void coro_close(lua_State* L)
+{
+  Coro* coro = coro_get(L);
+  if (!coro) {
+    return;
+  }
+  for (GList* l = coro->waits; l; l = l->next) {
+    CoroWait* wait = (CoroWait*)l->data;
+    if (wait->tag) {
+      g_source_remove(wait->tag);
+    }
+    g_free(wait);
+  }
+  g_list_free(coro->waits);
+  lua_pushnil(L);
+  lua_rawsetp(L, LUA_REGISTRYINDEX, &CORO_KEY);
+  g_free(coro);
+}
+
+void coro_set_error_handler(lua_State* L, CoroErrorFunc func, void* user_data)
+{
+  Coro* coro = coro_get(L);
+  coro->on_error = func;
+  coro->error_data = user_data;
+}
+
+void coro_set_budget(lua_State* L, int time, int instructions)
+{
+  Coro* coro = coro_get(L);
+  coro->budget.time = MAX(time, 0);
+  coro->budget.instructions = MAX(instructions, 0);
+}
+
+// Overrides the budget for the function at `index`, or removes the override if `budget` is NULL.
+void coro_set_function_budget(lua_State* L, int index, const CoroBudget* budget)
+{
+  index = lua_absindex(L, index);
+  if (lua_rawgetp(L, LUA_REGISTRYINDEX, &BUDGET_KEY) != LUA_TTABLE) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    // the budget goes away with the function
+    lua_newtable(L);
+    lua_pushstring(L, "k");
+    lua_setfield(L, -2, "__mode");
+    lua_setmetatable(L, -2);
+    lua_pushvalue(L, -1);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &BUDGET_KEY);
+  }
+  lua_pushvalue(L, index);
+  if (budget) {
+    CoroBudget* b = (CoroBudget*)lua_newuserdata(L, sizeof(CoroBudget));
+    b->time = MAX(budget->time, 0);
+    b->instructions = MAX(budget->instructions, 0);
+  } else {
+    lua_pushnil(L);
+  }
+  lua_rawset(L, -3);
+  lua_pop(L, 1);
+}
+
+static CoroBudget coro_get_budget(lua_State* L, Coro* coro, int index)
+{
+  CoroBudget budget = coro->budget;
+  index = lua_absindex(L, index);
+  if (lua_rawgetp(L, LUA_REGISTRYINDEX, &BUDGET_KEY) == LUA_TTABLE) {
+    lua_pushvalue(L, index);
+    if (lua_rawget(L, -2) == LUA_TUSERDATA) {
+      budget = *(CoroBudget*)lua_touserdata(L, -1);
+    }
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+  return budget;
+}
+
+// Counts instructions of the run, and aborts it with an error once it is over the budget.
+static void coro_watchdog(lua_State* L, lua_Debug* ar)
+{
+  Coro* coro = coro_get(L);
+  CoroRun* run = coro ? coro->current : NULL;
+  if (!run) {
+    return;
+  }
+  run->count += CORO_WATCHDOG_STEP;
+  char* message = NULL;
+  if (run->budget.instructions && run->count > run->budget.instructions) {
+    message = g_strdup_printf("Lua function is aborted since it ran over %d instructions.", run->budget.instructions);
+  } else if (run->budget.time && g_get_monotonic_time() > run->deadline) {
+    message = g_strdup_printf("Lua function is aborted since it ran over %d ms.", run->budget.time);
+  }
+  if (!message) {
+    return;
+  }
+  if (!run->aborted && coro->on_error) {
+    coro->on_error(coro->error_data, message);
+  }
+  // raised again on the next step if the error is caught by `pcall()`
+  run->aborted = true;
+  lua_pushstring(L, message);
+  g_free(message);
+  lua_error(L);
+}
+
+static int coro_resume(Coro* coro, lua_State* co, lua_State* from, int narg, CoroBudget budget)
+{
+  if (!coro) {
+    memory_enter(co);
+    int status = lua_resume(co, from, narg);
+    memory_leave(co);
+    return status;
+  }
+  CoroRun run = { budget, 0, 0, false, coro->current };
+  if (budget.time || budget.instructions) {
+    run.deadline = g_get_monotonic_time() + budget.time * (gint64)1000;
+    lua_sethook(co, coro_watchdog, LUA_MASKCOUNT, CORO_WATCHDOG_STEP);
+  } else if (lua_gethook(co)) {
+    lua_sethook(co, NULL, 0, 0);
+  }
+  coro->current = &run;
+  memory_enter(co);
+  int status = lua_resume(co, from, narg);
+  memory_leave(co);
+  coro->current = run.outer;
+  return status;
+}
+
+// Calls the function below `narg` arguments on the top of `L` in a coroutine, like `lua_pcall()`.
+// Returns LUA_OK with `nresult` results pushed, LUA_YIELD with nothing pushed if the function is
+// suspended, or an error status with the message pushed.
+int coro_run(lua_State* L, int narg, int nresult)
+{
+  assert(nresult >= 0);
+  Coro* coro = coro_get(L);
+  lua_State* co;
+  if (coro && coro->pool_size) {
+    int ref = coro->pool[--coro->pool_size];
+    lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+    luaL_unref(L, LUA_REGISTRYINDEX, ref);
+    co = lua_tothread(L, -1);
+  } else {
+    co = lua_newthread(L);
+  }
+  *coro_extra(co) = coro;
+  CoroBudget budget = { 0, 0 };
+  if (coro) {
+    budget = coro_get_budget(L, coro, - narg - 2);
+  }
+  // the thread stays on the stack of `L` while it runs
+  lua_insert(L, - narg - 2);
+  lua_xmove(L, co, narg + 1);
+
+  int status = coro_resume(coro, co, L, narg, budget);
+  if (status == LUA_OK) {
+    lua_settop(co, nresult);
+    lua_xmove(co, L, nresult);
+    if (coro && coro->pool_size < CORO_POOL_SIZE) {
+      lua_pushvalue(L, - nresult - 1);
+      coro->pool[coro->pool_size++] = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    lua_remove(L, - nresult - 1);
+    return LUA_OK;
+  }
+  if (status == LUA_YIELD) {
+    // resumed by whoever suspended it
+    lua_pop(L, 1);
+    return LUA_YIELD;
+  }
+  lua_xmove(co, L, 1); // error
+  lua_remove(L, -2);
+  return status;
+}
+
+// Whether `L` is a coroutine started by `coro_run()` which can be suspended.
+bool coro_is_managed(lua_State* L)
+{
+  return lua_isyieldable(L) && *coro_extra(L);
+}
+
+// Suspends the coroutine `L` until `coro_wait_resume()`. The caller returns `lua_yield(L, 0)` right after this.
+CoroWait* coro_wait_new(lua_State* L)
+{
+  assert(coro_is_managed(L));
+  Coro* coro = *coro_extra(L);
+  CoroWait* wait = g_malloc0(sizeof(CoroWait));
+  wait->coro = coro;
+  wait->co = L;
+  // the budget is renewed for each resume
+  wait->budget = coro->current ? coro->current->budget : coro->budget;
+  Memory* memory = memory_get(L);
+  wait->phase = memory ? memory->phase : MEMORY_PHASE_OTHER;
+  lua_pushthread(L);
+  wait->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  coro->waits = g_list_prepend(coro->waits, wait);
+  return wait;
+}
+
+// `narg` values pushed on `wait->co` are returned from the yield. `wait` is freed.
+void coro_wait_resume(CoroWait* wait, int narg)
+{
+  Coro* coro = wait->coro;
+  lua_State* co = wait->co;
+  int ref = wait->ref;
+  CoroBudget budget = wait->budget;
+  MemoryPhase phase = memory_set_phase(co, wait->phase);
+  coro->waits = g_list_remove(coro->waits, wait);
+  g_free(wait);
+
+  int status = coro_resume(coro, co, NULL, narg, budget);
+  if (status == LUA_OK) {
+    lua_settop(co, 0);
+  } else if (status != LUA_YIELD) {
+    luaX_warn(co, "Error in coroutine: '%s'", lua_tostring(co, -1));
+    lua_pop(co, 1); // error
+  }
+  luaL_unref(co, LUA_REGISTRYINDEX, ref);
+  memory_set_phase(co, phase);
+}
+
+static gboolean on_sleep_timeout(void* user_data)
+{
+  CoroWait* wait = (CoroWait*)user_data;
+  wait->tag = 0;
+  coro_wait_resume(wait, 0);
+  return G_SOURCE_REMOVE;
+}
+
+int coro_sleep(lua_State* L, unsigned msec)
+{
+  CoroWait* wait = coro_wait_new(L);
+  wait->tag = g_timeout_add(msec, on_sleep_timeout, wait);
+  return lua_yield(L, 0);
+}
@@ -0,0 +1,111 @@
+/**
+ * coro_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "coro.h"
+
+
+static int sleep_func(lua_State* L)
+{
+  if (!coro_is_managed(L)) {
+    return luaL_error(L, "not managed");
+  }
+  return coro_sleep(L, luaL_checkinteger(L, 1));
+}
+
+static int guard_depth = 0;
+
+// The same as `tym.batch()`, which must not keep its state across a wait.
+static int guard_func(lua_State* L)
+{
+  luaL_checktype(L, 1, LUA_TFUNCTION);
+  lua_settop(L, 1);
+  guard_depth += 1;
+  int result = lua_pcall(L, 0, LUA_MULTRET, 0);
+  guard_depth -= 1;
+  if (result != LUA_OK) {
+    return lua_error(L);
+  }
+  return lua_gettop(L);
+}
+
+static int run(lua_State* L, const char* code)
+{
+  luaL_loadstring(L, code);
+  return coro_run(L, 0, 1);
+}
+
+void test_coro()
+{
+  lua_State* L = luaL_newstate();
+  luaL_openlibs(L);
+  coro_init(L);
+  lua_register(L, "sleep", sleep_func);
+
+  g_assert_cmpint(run(L, "return 1 + 1"), ==, LUA_OK);
+  g_assert_cmpint(lua_tointeger(L, -1), ==, 2);
+  lua_pop(L, 1);
+
+  g_assert_cmpint(run(L, "error('boom')"), ==, LUA_ERRRUN);
+  g_assert_nonnull(g_strrstr(lua_tostring(L, -1), "boom"));
+  lua_pop(L, 1);
+
+  // not in a coroutine started by coro_run()
+  g_assert_cmpint(luaL_dostring(L, "sleep(0)"), !=, LUA_OK);
+  lua_pop(L, 1);
+
+  g_assert_cmpint(run(L, "done = false sleep(1) done = true"), ==, LUA_YIELD);
+  g_assert_cmpint(lua_gettop(L), ==, 0);
+  lua_getglobal(L, "done");
+  g_assert_false(lua_toboolean(L, -1));
+  lua_pop(L, 1);
+
+  gint64 deadline = g_get_monotonic_time() + G_USEC_PER_SEC;
+  bool done = false;
+  while (!done && g_get_monotonic_time() < deadline) {
+    g_main_context_iteration(NULL, true);
+    lua_getglobal(L, "done");
+    done = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+  }
+  g_assert_true(done);
+
+  // a function called by a C function cannot wait, even in a managed coroutine
+  lua_register(L, "guard", guard_func);
+  g_assert_cmpint(run(L, "return select(2, pcall(guard, function() sleep(1) end))"), ==, LUA_OK);
+  g_assert_nonnull(g_strrstr(lua_tostring(L, -1), "not managed"));
+  lua_pop(L, 1);
+  g_assert_cmpint(run(L, "return select(2, pcall(guard, coroutine.yield))"), ==, LUA_OK);
+  g_assert_nonnull(g_strrstr(lua_tostring(L, -1), "C-call boundary"));
+  lua_pop(L, 1);
+  g_assert_cmpint(guard_depth, ==, 0);
+
+  coro_set_budget(L, 0, 10000);
+  g_assert_cmpint(run(L, "while true do end"), ==, LUA_ERRRUN);
+  g_assert_nonnull(g_strrstr(lua_tostring(L, -1), "instructions"));
+  lua_pop(L, 1);
+
+  // still aborted when the error is caught
+  g_assert_cmpint(run(L, "pcall(function() while true do end end) while true do end"), ==, LUA_ERRRUN);
+  lua_pop(L, 1);
+
+  // the budget of the function overrides the default one
+  luaL_loadstring(L, "for i = 1, 100000 do end return true");
+  CoroBudget unlimited = { 0, 0 };
+  coro_set_function_budget(L, -1, &unlimited);
+  g_assert_cmpint(coro_run(L, 0, 1), ==, LUA_OK);
+  g_assert_true(lua_toboolean(L, -1));
+  lua_pop(L, 1);
+  coro_set_budget(L, 0, 0);
+
+  // suspended again and dropped on close
+  g_assert_cmpint(run(L, "sleep(1000)"), ==, LUA_YIELD);
+  coro_close(L);
+  lua_close(L);
+}
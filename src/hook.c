@@ -10,215 +10,452 @@
 #include "hook.h"
 
 
-#define HOOK_KEY_TITLE "title"
-#define HOOK_KEY_BELL "bell"
-#define HOOK_KEY_CLICKED "clicked"
-#define HOOK_KEY_SCROLL "scroll"
-#define HOOK_KEY_DRAG "drag"
-#define HOOK_KEY_ACTIVATED "activated"
-#define HOOK_KEY_DEACTIVATED "deactivated"
-#define HOOK_KEY_SELECTED "selected"
-#define HOOK_KEY_UNSELECTED "unselected"
-
-
-const char* HOOK_KEYS[] = {
-  HOOK_KEY_TITLE,
-  HOOK_KEY_BELL,
-  HOOK_KEY_CLICKED,
-  HOOK_KEY_SCROLL,
-  HOOK_KEY_DRAG,
-  HOOK_KEY_ACTIVATED,
-  HOOK_KEY_DEACTIVATED,
-  HOOK_KEY_SELECTED,
-  HOOK_KEY_UNSELECTED,
-  NULL
+static const char* HOOK_KEYS[HOOK_COUNT] = {
+  [HOOK_TITLE] = "title",
+  [HOOK_BELL] = "bell",
+  [HOOK_CLICKED] = "clicked",
+  [HOOK_SCROLL] = "scroll",
+  [HOOK_DRAG] = "drag",
+  [HOOK_ACTIVATED] = "activated",
+  [HOOK_DEACTIVATED] = "deactivated",
+  [HOOK_SELECTED] = "selected",
+  [HOOK_UNSELECTED] = "unselected",
 };
 
+static void hook_subscriber_free(HookSubscriber* subscriber)
+{
+  hook_filter_free(subscriber->filter);
+  g_free(subscriber);
+}
+
 Hook* hook_init()
 {
   Hook* hook = g_malloc0(sizeof(Hook));
-  hook->refs = g_hash_table_new_full(
-    g_str_hash,
-    g_str_equal,
-    (GDestroyNotify)g_free,
-    (GDestroyNotify)g_free
-  );
-
-  int i = 0;
-  while (HOOK_KEYS[i]) {
-    int* p = g_malloc0(sizeof(int));
-    *p = -1;
-    g_hash_table_insert(hook->refs, g_strdup(HOOK_KEYS[i]), p);
-    i += 1;
+  for (unsigned i = 0; i < HOOK_COUNT; i++) {
+    hook->subscribers[i] = g_ptr_array_new_with_free_func((GDestroyNotify)hook_subscriber_free);
   }
   return hook;
 }
 
 void hook_close(Hook* hook)
 {
-  g_hash_table_destroy(hook->refs);
+  for (unsigned i = 0; i < HOOK_COUNT; i++) {
+    g_ptr_array_unref(hook->subscribers[i]);
+  }
+  g_slist_free_full(hook->pending, (GDestroyNotify)hook_subscriber_free);
   g_free(hook);
 }
 
-static int hook_get_ref(Hook* hook, const char* key)
+bool hook_get_type(const char* key, HookType* type)
 {
-  int* ptr = g_hash_table_lookup(hook->refs, key);
-  if (!ptr) {
-    dd("invalid hook key: '%s'", key);
-    return -1;
+  for (unsigned i = 0; i < HOOK_COUNT; i++) {
+    if (is_equal(HOOK_KEYS[i], key)) {
+      *type = i;
+      return true;
+    }
   }
-  return *ptr;
+  return false;
 }
 
-bool hook_set_ref(Hook* hook, const char* key, int ref, int* old_ref)
+// Keeps higher priorities first and, within a priority, the order of addition.
+static void hook_insert(Hook* hook, HookSubscriber* subscriber)
 {
-  assert(old_ref);
-  void* old_key = NULL;
-  void* old_value = NULL;
-  bool has_value = g_hash_table_lookup_extended(hook->refs, key, &old_key, &old_value);
-  if (old_value) {
-    *old_ref = *(int*)old_value;
+  GPtrArray* subscribers = hook->subscribers[subscriber->type];
+  unsigned i = subscribers->len;
+  while (i > 0 && ((HookSubscriber*)g_ptr_array_index(subscribers, i - 1))->priority < subscriber->priority) {
+    i--;
   }
-  if (!has_value) {
-    return false;
+  g_ptr_array_insert(subscribers, i, subscriber);
+}
+
+// Subscribers added or removed by a hook function take effect after the current dispatch,
+// so the array is never modified while it is iterated.
+static void hook_flush(Hook* hook)
+{
+  if (hook->dispatching) {
+    return;
+  }
+  if (hook->dirty) {
+    for (unsigned t = 0; t < HOOK_COUNT; t++) {
+      GPtrArray* subscribers = hook->subscribers[t];
+      for (unsigned i = subscribers->len; i > 0; i--) {
+        if (((HookSubscriber*)g_ptr_array_index(subscribers, i - 1))->ref == LUA_NOREF) {
+          g_ptr_array_remove_index(subscribers, i - 1);
+        }
+      }
+    }
+    hook->dirty = false;
+  }
+  if (hook->pending) {
+    hook->pending = g_slist_reverse(hook->pending);
+    for (GSList* l = hook->pending; l; l = l->next) {
+      hook_insert(hook, (HookSubscriber*)l->data);
+    }
+    g_slist_free(hook->pending);
+    hook->pending = NULL;
   }
-  g_hash_table_remove(hook->refs, old_key);
-  g_hash_table_insert(hook->refs, g_strdup(key), g_memdup(&ref, sizeof(int)));
-  dd("hook (%s) is registered. ref: %d", key, ref);
-  return true;
 }
 
-static bool hook_perform(Hook* hook, lua_State* L, const char* key, int narg, int nresult)
+// The filter is owned by the hook. Returns the handle of the subscriber.
+int hook_add(Hook* hook, HookType type, int ref, int priority, HookFilter* filter)
 {
-  int ref = hook_get_ref(hook, key);
-  if (ref < 0) {
-    lua_pop(L, narg);
-    return false;
+  HookSubscriber* subscriber = g_new0(HookSubscriber, 1);
+  subscriber->handle = ++hook->last_handle;
+  subscriber->type = type;
+  subscriber->ref = ref;
+  subscriber->priority = priority;
+  subscriber->filter = filter;
+  if (hook->dispatching) {
+    hook->pending = g_slist_prepend(hook->pending, subscriber);
+  } else {
+    hook_insert(hook, subscriber);
   }
-  lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
-  if (!lua_isfunction(L, -1)) {
-    lua_pop(L, 1); // pop none-function
-    dd("tried to call hook which is not function.");
-    return false;
+  dd("hook (%s) is subscribed. handle: %d, ref: %d", HOOK_KEYS[type], subscriber->handle, ref);
+  return subscriber->handle;
+}
+
+// Sets `ref` to the Lua ref of the removed subscriber, which the caller has to unref.
+bool hook_remove(Hook* hook, int handle, int* ref)
+{
+  assert(ref);
+  for (GSList* l = hook->pending; l; l = l->next) {
+    HookSubscriber* subscriber = (HookSubscriber*)l->data;
+    if (subscriber->handle == handle) {
+      *ref = subscriber->ref;
+      if (hook->set_handles[subscriber->type] == handle) {
+        hook->set_handles[subscriber->type] = 0;
+      }
+      hook->pending = g_slist_delete_link(hook->pending, l);
+      hook_subscriber_free(subscriber);
+      return true;
+    }
+  }
+  for (unsigned t = 0; t < HOOK_COUNT; t++) {
+    GPtrArray* subscribers = hook->subscribers[t];
+    for (unsigned i = 0; i < subscribers->len; i++) {
+      HookSubscriber* subscriber = (HookSubscriber*)g_ptr_array_index(subscribers, i);
+      if (subscriber->handle != handle || subscriber->ref == LUA_NOREF) {
+        continue;
+      }
+      *ref = subscriber->ref;
+      if (hook->set_handles[t] == handle) {
+        hook->set_handles[t] = 0;
+      }
+      subscriber->ref = LUA_NOREF;
+      hook->dirty = true;
+      hook_flush(hook);
+      return true;
+    }
   }
-  lua_insert(L, - narg - 1);
-  dd("perform custom hook: %s", key);
-  if (lua_pcall(L, narg, nresult, 0) != LUA_OK) {
-    luaX_warn(L, "Error in hook function: '%s'", lua_tostring(L, -1));
-    lua_pop(L, 1); // error
+  return false;
+}
+
+// `tym.set_hook()` owns one subscriber per hook and replaces only that one.
+bool hook_set_ref(Hook* hook, const char* key, int ref, HookFilter* filter, int* old_ref)
+{
+  assert(old_ref);
+  HookType type;
+  if (!hook_get_type(key, &type)) {
+    dd("invalid hook key: '%s'", key);
     return false;
   }
+  *old_ref = LUA_NOREF;
+  if (hook->set_handles[type]) {
+    hook_remove(hook, hook->set_handles[type], old_ref);
+  }
+  hook->set_handles[type] = hook_add(hook, type, ref, 0, filter);
   return true;
 }
 
-bool hook_perform_title(Hook* hook, lua_State* L, const char* title, bool* result)
+static unsigned hook_parse_button(lua_State* L)
 {
-  if (!L) {
-    return false;
+  int isnum = 0;
+  lua_Integer button = lua_tointegerx(L, -1, &isnum);
+  if (!isnum || button < 1 || button > 31) {
+    luaL_error(L, "Invalid button in hook filter: %s", luaL_tolstring(L, -1, NULL));
   }
-  lua_pushstring(L, title);
-  bool succeeded = hook_perform(hook, L, HOOK_KEY_TITLE, 1, 1);
-  if (!succeeded) {
-    return false;
+  return 1u << button;
+}
+
+// Raises a Lua error for an invalid field. Nothing is allocated until every field is read.
+HookFilter* hook_filter_new(lua_State* L, int index)
+{
+  index = lua_absindex(L, index);
+  luaL_checktype(L, index, LUA_TTABLE);
+
+  unsigned buttons = 0;
+  lua_getfield(L, index, "button");
+  if (lua_istable(L, -1)) {
+    lua_pushnil(L);
+    while (lua_next(L, -2)) {
+      buttons |= hook_parse_button(L);
+      lua_pop(L, 1);
+    }
+  } else if (!lua_isnil(L, -1)) {
+    buttons = hook_parse_button(L);
+  }
+  lua_pop(L, 1);
+
+  unsigned mods = 0;
+  lua_getfield(L, index, "modifier");
+  if (!lua_isnil(L, -1)) {
+    const char* accelerator = lua_tostring(L, -1);
+    unsigned key;
+    GdkModifierType mod = 0;
+    if (accelerator) {
+      gtk_accelerator_parse(accelerator, &key, &mod);
+    }
+    if (!mod) {
+      luaL_error(L, "Invalid modifier in hook filter: %s", luaL_tolstring(L, -1, NULL));
+    }
+    mods = mod & gtk_accelerator_get_default_mod_mask();
+  }
+  lua_pop(L, 1);
+
+  gint64 interval = 0;
+  lua_getfield(L, index, "interval");
+  if (!lua_isnil(L, -1)) {
+    int isnum = 0;
+    lua_Integer ms = lua_tointegerx(L, -1, &isnum);
+    if (!isnum || ms < 0) {
+      luaL_error(L, "Invalid interval in hook filter: %s", luaL_tolstring(L, -1, NULL));
+    }
+    interval = ms * 1000;
+  }
+  lua_pop(L, 1);
+
+  GRegex* regex = NULL;
+  lua_getfield(L, index, "pattern");
+  if (!lua_isnil(L, -1)) {
+    const char* pattern = lua_tostring(L, -1);
+    if (!pattern) {
+      luaL_error(L, "Invalid pattern in hook filter: string expected, got %s", luaL_typename(L, -1));
+    }
+    GError* error = NULL;
+    regex = g_regex_new(pattern, G_REGEX_OPTIMIZE, 0, &error);
+    if (!regex) {
+      lua_pushfstring(L, "Invalid pattern in hook filter: %s", error->message);
+      g_error_free(error);
+      lua_error(L);
+    }
   }
-  *result = lua_toboolean(L, -1);
   lua_pop(L, 1);
-  return succeeded;
+
+  HookFilter* filter = g_new0(HookFilter, 1);
+  filter->buttons = buttons;
+  filter->mods = mods;
+  filter->regex = regex;
+  filter->interval = interval;
+  return filter;
 }
 
-bool hook_perform_bell(Hook* hook, lua_State* L, bool* result)
+void hook_filter_free(HookFilter* filter)
 {
-  assert(result);
-  if (!L) {
-    return false;
+  if (!filter) {
+    return;
   }
-  bool succeeded = hook_perform(hook, L, HOOK_KEY_BELL, 0, 1);
-  if (!succeeded) {
-    return false;
+  if (filter->regex) {
+    g_regex_unref(filter->regex);
   }
-  *result = lua_toboolean(L, -1);
-  lua_pop(L, 1);
-  return succeeded;
+  g_free(filter);
 }
 
-bool hook_perform_clicked(Hook* hook, lua_State* L, int button, const char* uri, bool* result)
+// `button` is 0 and `text` is NULL for events which do not have them.
+bool hook_filter_match(HookFilter* filter, int button, unsigned mods, const char* text)
 {
-  assert(result);
-  if (!L) {
+  if (filter->buttons && !(button > 0 && button < 32 && (filter->buttons & (1u << button)))) {
     return false;
   }
-  lua_pushinteger(L, button);
-  lua_pushstring(L, uri);
-  bool succeeded = hook_perform(hook, L, HOOK_KEY_CLICKED, 2, 1);
-  if (!succeeded) {
+  if ((mods & filter->mods) != filter->mods) {
     return false;
   }
-  *result = lua_toboolean(L, -1);
-  lua_pop(L, 1);
-  return succeeded;
+  if (filter->regex && !(text && g_regex_match(filter->regex, text, 0, NULL))) {
+    return false;
+  }
+  if (filter->interval) {
+    gint64 now = g_get_monotonic_time();
+    if (filter->last_time && now - filter->last_time < filter->interval) {
+      return false;
+    }
+    filter->last_time = now;
+  }
+  return true;
 }
 
-bool hook_perform_scroll(Hook* hook, lua_State* L, double delta_x, double delta_y, double x, double y, bool* result)
-{
-  assert(result);
-  if (!L) {
+typedef int (*HookPushFunc)(lua_State* L, const void* data);
+
+// Calls the matching subscribers in order until one returns true. The arguments are pushed
+// by `push` when the first subscriber matches and are shared by the rest.
+static bool hook_dispatch(
+  Hook* hook,
+  lua_State* L,
+  HookType type,
+  int button,
+  unsigned mods,
+  const char* text,
+  HookPushFunc push,
+  const void* data,
+  bool* result
+) {
+  if (!L || !hook_has(hook, type)) {
     return false;
   }
-  lua_pushnumber(L, delta_x);
-  lua_pushnumber(L, delta_y);
-  lua_pushnumber(L, x);
-  lua_pushnumber(L, x);
-  bool succeeded = hook_perform(hook, L, HOOK_KEY_SCROLL, 4, 1);
-  if (!succeeded) {
-    return false;
+  GPtrArray* subscribers = hook->subscribers[type];
+  bool performed = false;
+  bool handled = false;
+  int narg = -1;
+  hook->dispatching++;
+  for (unsigned i = 0; i < subscribers->len && !handled; i++) {
+    HookSubscriber* subscriber = (HookSubscriber*)g_ptr_array_index(subscribers, i);
+    if (subscriber->ref == LUA_NOREF) {
+      continue;
+    }
+    if (subscriber->filter && !hook_filter_match(subscriber->filter, button, mods, text)) {
+      dd("hook (%s:%d) is filtered out", HOOK_KEYS[type], subscriber->handle);
+      continue;
+    }
+    if (narg < 0) {
+      narg = push ? push(L, data) : 0;
+    }
+    lua_rawgeti(L, LUA_REGISTRYINDEX, subscriber->ref);
+    if (!lua_isfunction(L, -1)) {
+      lua_pop(L, 1);
+      dd("tried to call hook which is not function.");
+      continue;
+    }
+    for (int j = 0; j < narg; j++) {
+      lua_pushvalue(L, - narg - 1);
+    }
+    dd("perform custom hook: %s:%d", HOOK_KEYS[type], subscriber->handle);
+    MemoryPhase phase = memory_set_phase(L, MEMORY_PHASE_HOOK);
+    int status = coro_run(L, narg, 1);
+    memory_set_phase(L, phase);
+    if (status == LUA_YIELD) {
+      // the rest of it runs later, so its result cannot cancel the default action
+      performed = true;
+      continue;
+    }
+    if (status != LUA_OK) {
+      luaX_warn(L, "Error in hook function: '%s'", lua_tostring(L, -1));
+      lua_pop(L, 1); // error
+      continue;
+    }
+    performed = true;
+    handled = lua_toboolean(L, -1);
+    lua_pop(L, 1);
   }
-  *result = lua_toboolean(L, -1);
-  lua_pop(L, 1);
-  return succeeded;
+  if (narg > 0) {
+    lua_pop(L, narg);
+  }
+  hook->dispatching--;
+  hook_flush(hook);
+  if (result) {
+    *result = handled;
+  }
+  return performed;
+}
+
+static int hook_push_string(lua_State* L, const void* data)
+{
+  lua_pushstring(L, (const char*)data);
+  return 1;
+}
+
+bool hook_perform_title(Hook* hook, lua_State* L, const char* title, bool* result)
+{
+  return hook_dispatch(hook, L, HOOK_TITLE, 0, 0, title, hook_push_string, title, result);
+}
+
+static int hook_push_bell(lua_State* L, const void* data)
+{
+  lua_pushinteger(L, *(const unsigned*)data);
+  return 1;
+}
+
+bool hook_perform_bell(Hook* hook, lua_State* L, unsigned count, bool* result)
+{
+  assert(result);
+  return hook_dispatch(hook, L, HOOK_BELL, 0, 0, NULL, hook_push_bell, &count, result);
+}
+
+// Pushes the modifiers as an accelerator like `'<Primary><Shift>'`, which `tym.check_mod_state()` accepts too.
+static void hook_push_mods(lua_State* L, unsigned mods)
+{
+  char* accelerator = gtk_accelerator_name(0, mods);
+  lua_pushstring(L, accelerator);
+  g_free(accelerator);
+}
+
+typedef struct {
+  int button;
+  const char* uri;
+  unsigned mods;
+} HookClickedArgs;
+
+static int hook_push_clicked(lua_State* L, const void* data)
+{
+  const HookClickedArgs* args = (const HookClickedArgs*)data;
+  lua_pushinteger(L, args->button);
+  lua_pushstring(L, args->uri);
+  hook_push_mods(L, args->mods);
+  return 3;
+}
+
+bool hook_perform_clicked(Hook* hook, lua_State* L, int button, unsigned mods, const char* uri, bool* result)
+{
+  assert(result);
+  HookClickedArgs args = { button, uri, mods };
+  return hook_dispatch(hook, L, HOOK_CLICKED, button, mods, uri, hook_push_clicked, &args, result);
+}
+
+typedef struct {
+  double delta_x;
+  double delta_y;
+  double x;
+  double y;
+  unsigned mods;
+} HookScrollArgs;
+
+static int hook_push_scroll(lua_State* L, const void* data)
+{
+  const HookScrollArgs* args = (const HookScrollArgs*)data;
+  lua_pushnumber(L, args->delta_x);
+  lua_pushnumber(L, args->delta_y);
+  lua_pushnumber(L, args->x);
+  lua_pushnumber(L, args->y);
+  hook_push_mods(L, args->mods);
+  return 5;
+}
+
+bool hook_perform_scroll(Hook* hook, lua_State* L, double delta_x, double delta_y, double x, double y, unsigned mods, bool* result)
+{
+  assert(result);
+  HookScrollArgs args = { delta_x, delta_y, x, y, mods };
+  return hook_dispatch(hook, L, HOOK_SCROLL, 0, mods, NULL, hook_push_scroll, &args, result);
 }
 
 bool hook_perform_drag(Hook* hook, lua_State* L, char* path, bool* result)
 {
   assert(result);
-  lua_pushstring(L, path);
-  bool succeeded = hook_perform(hook, L, HOOK_KEY_DRAG, 1, 1);
-  if (!succeeded) {
-    return false;
-  }
-  *result = lua_toboolean(L, -1);
-  lua_pop(L, 1);
-  return succeeded;
+  return hook_dispatch(hook, L, HOOK_DRAG, 0, 0, path, hook_push_string, path, result);
 }
 
 bool hook_perform_activated(Hook* hook, lua_State* L)
 {
-  if (!L) {
-    return false;
-  }
-  return hook_perform(hook, L, HOOK_KEY_ACTIVATED, 0, 0);
+  return hook_dispatch(hook, L, HOOK_ACTIVATED, 0, 0, NULL, NULL, NULL, NULL);
 }
 
 bool hook_perform_deactivated(Hook* hook, lua_State* L)
 {
-  if (!L) {
-    return false;
-  }
-  return hook_perform(hook, L, HOOK_KEY_DEACTIVATED, 0, 0);
+  return hook_dispatch(hook, L, HOOK_DEACTIVATED, 0, 0, NULL, NULL, NULL, NULL);
 }
 
 bool hook_perform_selected(Hook* hook, lua_State* L, const char* text)
 {
-  if (!L) {
-    return false;
-  }
-  lua_pushstring(L, text);
-  return hook_perform(hook, L, HOOK_KEY_SELECTED, 1, 0);
+  return hook_dispatch(hook, L, HOOK_SELECTED, 0, 0, text, hook_push_string, text, NULL);
 }
 
 bool hook_perform_unselected(Hook* hook, lua_State* L)
 {
-  if (!L) {
-    return false;
-  }
-  return hook_perform(hook, L, HOOK_KEY_UNSELECTED, 0, 0);
+  return hook_dispatch(hook, L, HOOK_UNSELECTED, 0, 0, NULL, NULL, NULL, NULL);
 }
@@ -0,0 +1,135 @@
+/**
+ * hook_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "hook.h"
+
+
+static int new_filter(lua_State* L)
+{
+  hook_filter_free(hook_filter_new(L, 1));
+  return 0;
+}
+
+static void test_filter()
+{
+  lua_State* L = luaL_newstate();
+  luaL_dostring(L, "return { button = { 1, 3 }, modifier = '<Ctrl>', pattern = '^https?:' }");
+  HookFilter* filter = hook_filter_new(L, -1);
+  lua_pop(L, 1);
+  unsigned ctrl = GDK_CONTROL_MASK;
+  g_assert_true(hook_filter_match(filter, 3, ctrl, "https://example.com"));
+  g_assert_true(hook_filter_match(filter, 1, ctrl | GDK_SHIFT_MASK, "http://example.com"));
+  g_assert_false(hook_filter_match(filter, 2, ctrl, "https://example.com"));
+  g_assert_false(hook_filter_match(filter, 3, 0, "https://example.com"));
+  g_assert_false(hook_filter_match(filter, 3, ctrl, "ftp://example.com"));
+  g_assert_false(hook_filter_match(filter, 3, ctrl, NULL));
+  hook_filter_free(filter);
+
+  luaL_dostring(L, "return { interval = 60000 }");
+  filter = hook_filter_new(L, -1);
+  lua_pop(L, 1);
+  g_assert_true(hook_filter_match(filter, 0, 0, NULL));
+  g_assert_false(hook_filter_match(filter, 0, 0, NULL));
+  hook_filter_free(filter);
+
+  lua_pushcfunction(L, new_filter);
+  luaL_dostring(L, "return { pattern = '(' }");
+  g_assert_cmpint(lua_pcall(L, 1, 0, 0), !=, LUA_OK);
+  lua_pushcfunction(L, new_filter);
+  luaL_dostring(L, "return { button = 0 }");
+  g_assert_cmpint(lua_pcall(L, 1, 0, 0), !=, LUA_OK);
+  lua_close(L);
+}
+
+static int ref_function(lua_State* L, const char* code)
+{
+  luaL_dostring(L, code);
+  return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+static void test_subscribers()
+{
+  lua_State* L = luaL_newstate();
+  luaL_openlibs(L);
+  luaL_dostring(L, "calls = ''");
+  Hook* hook = hook_init();
+  hook_add(hook, HOOK_BELL, ref_function(L, "return function() calls = calls .. 'a' end"), 0, NULL);
+  int b = hook_add(hook, HOOK_BELL, ref_function(L, "return function() calls = calls .. 'b' end"), 10, NULL);
+  hook_add(hook, HOOK_BELL, ref_function(L, "return function() calls = calls .. 'c' end"), 0, NULL);
+  int stop = hook_add(hook, HOOK_BELL, ref_function(L, "return function() calls = calls .. 's' return true end"), 5, NULL);
+
+  bool result = false;
+  g_assert_true(hook_perform_bell(hook, L, 1, &result));
+  g_assert_true(result);
+  luaL_dostring(L, "return calls");
+  g_assert_cmpstr(lua_tostring(L, -1), ==, "bs");
+  lua_pop(L, 1);
+
+  int ref = LUA_NOREF;
+  g_assert_true(hook_remove(hook, stop, &ref));
+  g_assert_false(hook_remove(hook, stop, &ref));
+  luaL_dostring(L, "calls = ''");
+  g_assert_true(hook_perform_bell(hook, L, 1, &result));
+  g_assert_false(result);
+  luaL_dostring(L, "return calls");
+  g_assert_cmpstr(lua_tostring(L, -1), ==, "bac");
+  lua_pop(L, 1);
+
+  // tym.set_hook() replaces only its own subscriber
+  int old_ref = 0;
+  g_assert_true(hook_set_ref(hook, "bell", ref_function(L, "return function() calls = calls .. 'x' end"), NULL, &old_ref));
+  g_assert_true(hook_set_ref(hook, "bell", ref_function(L, "return function() calls = calls .. 'y' end"), NULL, &old_ref));
+  g_assert_true(hook_remove(hook, b, &ref));
+  luaL_dostring(L, "calls = ''");
+  hook_perform_bell(hook, L, 1, &result);
+  luaL_dostring(L, "return calls");
+  g_assert_cmpstr(lua_tostring(L, -1), ==, "acy");
+  lua_pop(L, 1);
+  g_assert_cmpint(lua_gettop(L), ==, 0);
+
+  // the modifiers are passed as an accelerator
+  hook_add(hook, HOOK_CLICKED, ref_function(L, "return function(button, uri, modifier) mods = modifier end"), 0, NULL);
+  hook_perform_clicked(hook, L, 1, GDK_SHIFT_MASK, NULL, &result);
+  luaL_dostring(L, "return mods");
+  g_assert_cmpstr(lua_tostring(L, -1), ==, "<Shift>");
+  lua_pop(L, 1);
+
+  hook_close(hook);
+  lua_close(L);
+}
+
+void test_hook()
+{
+  test_filter();
+  test_subscribers();
+
+  Hook* hook = hook_init();
+  for (unsigned i = 0; i < HOOK_COUNT; i++) {
+    g_assert_false(hook_has(hook, i));
+  }
+
+  int old_ref = 0;
+  g_assert_true(hook_set_ref(hook, "selected", 3, NULL, &old_ref));
+  g_assert_cmpint(old_ref, ==, LUA_NOREF);
+  g_assert_true(hook_has(hook, HOOK_SELECTED));
+  g_assert_false(hook_has(hook, HOOK_UNSELECTED));
+
+  g_assert_true(hook_set_ref(hook, "selected", 4, NULL, &old_ref));
+  g_assert_cmpint(old_ref, ==, 3);
+
+  old_ref = 0;
+  g_assert_false(hook_set_ref(hook, "unknown", 5, NULL, &old_ref));
+  g_assert_cmpint(old_ref, ==, 0);
+
+  // no Lua state is needed while nothing is registered
+  bool result = false;
+  g_assert_false(hook_perform_bell(hook, NULL, 1, &result));
+  hook_close(hook);
+}
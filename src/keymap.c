@@ -10,101 +10,329 @@
 #include "keymap.h"
 
 
-typedef struct {
-  unsigned key;
-  GdkModifierType mod;
-  char* accelerator;
-  int ref;
-} KeymapEntry;
+// User bindings and default actions share one trie per mode so that a key press costs one lookup.
+static inline gint64 pack(unsigned key, GdkModifierType mod)
+{
+  return ((gint64)mod << 32) | key;
+}
+
+static void free_node(KeymapNode* node)
+{
+  if (node->children) {
+    g_hash_table_destroy(node->children);
+  }
+  g_free(node);
+}
+
+static KeymapNode* new_node(unsigned key, GdkModifierType mod)
+{
+  KeymapNode* node = g_malloc0(sizeof(KeymapNode));
+  node->binding.key = key;
+  node->binding.mod = mod;
+  node->binding.ref = LUA_NOREF;
+  node->binding.default_id = -1;
+  return node;
+}
+
+static KeymapNode* get_child(KeymapNode* node, unsigned key, GdkModifierType mod)
+{
+  if (!node->children) {
+    return NULL;
+  }
+  gint64 packed = pack(key, mod);
+  return g_hash_table_lookup(node->children, &packed);
+}
 
+static KeymapNode* ensure_child(KeymapNode* node, unsigned key, GdkModifierType mod)
+{
+  KeymapNode* child = get_child(node, key, mod);
+  if (child) {
+    return child;
+  }
+  if (!node->children) {
+    node->children = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, (GDestroyNotify)free_node);
+  }
+  child = new_node(key, mod);
+  gint64* packed = g_new(gint64, 1);
+  *packed = pack(key, mod);
+  g_hash_table_insert(node->children, packed, child);
+  return child;
+}
 
-static void free_keymap_entry(KeymapEntry* e, void* user_data)
+static bool is_node_empty(KeymapNode* node)
 {
+  return node->binding.ref == LUA_NOREF
+    && node->binding.default_id < 0
+    && (!node->children || g_hash_table_size(node->children) == 0);
+}
+
+static gboolean clear_refs(void* key, void* value, void* user_data)
+{
+  KeymapNode* node = (KeymapNode*)value;
   // TODO: luaL_unref the ref
-  g_free(e->accelerator);
-  g_free(e);
+  node->binding.ref = LUA_NOREF;
+  if (node->children) {
+    g_hash_table_foreach_remove(node->children, clear_refs, NULL);
+  }
+  return is_node_empty(node);
+}
+
+static KeymapNode* get_root(Keymap* keymap, const char* mode, bool create)
+{
+  KeymapNode* root = g_hash_table_lookup(keymap->modes, mode);
+  if (!root && create) {
+    root = new_node(0, 0);
+    g_hash_table_insert(keymap->modes, g_strdup(mode), root);
+  }
+  return root;
+}
+
+// Parses space-separated accelerators into `keys` and `mods`. Returns the number of strokes, or 0 if any is invalid.
+static unsigned parse_chord(const char* accelerator, unsigned** keys, GdkModifierType** mods)
+{
+  char** strokes = g_strsplit_set(accelerator, " ", -1);
+  unsigned count = 0;
+  *keys = g_new0(unsigned, g_strv_length(strokes));
+  *mods = g_new0(GdkModifierType, g_strv_length(strokes));
+  for (char** s = strokes; *s; s++) {
+    if (is_empty(*s)) {
+      continue;
+    }
+    gtk_accelerator_parse(*s, &(*keys)[count], &(*mods)[count]);
+    if (0 == (*keys)[count] && 0 == (*mods)[count]) {
+      count = 0;
+      break;
+    }
+    count += 1;
+  }
+  g_strfreev(strokes);
+  return count;
 }
 
 Keymap* keymap_init()
 {
   Keymap* keymap = g_malloc0(sizeof(Keymap));
-  keymap->entries = NULL;
-
+  keymap->modes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)free_node);
+  keymap->defaults = g_array_new(false, false, sizeof(KeymapBinding));
+  keymap->mode = g_strdup(KEYMAP_DEFAULT_MODE);
+  keymap->root = get_root(keymap, KEYMAP_DEFAULT_MODE, true);
   return keymap;
 }
 
 void keymap_reset(Keymap* keymap)
 {
-  g_list_foreach(keymap->entries, (GFunc)free_keymap_entry, NULL);
-  g_list_free(keymap->entries);
-  keymap->entries = NULL;
+  keymap->pending = NULL;
+  GHashTableIter iter;
+  void* value;
+  g_hash_table_iter_init(&iter, keymap->modes);
+  while (g_hash_table_iter_next(&iter, NULL, &value)) {
+    clear_refs(NULL, value, NULL);
+  }
 }
 
 void keymap_close(Keymap* keymap)
 {
-  keymap_reset(keymap);
+  g_hash_table_destroy(keymap->modes);
+  g_array_free(keymap->defaults, true);
+  g_free(keymap->mode);
   g_free(keymap);
 }
 
-bool keymap_add_entry(Keymap* keymap, const char* accelerator, int ref)
+void keymap_add_default(Keymap* keymap, unsigned key, GdkModifierType mod, int id)
+{
+  KeymapNode* root = get_root(keymap, KEYMAP_DEFAULT_MODE, true);
+  KeymapNode* node = ensure_child(root, key, mod);
+  node->binding.default_id = id;
+  g_array_append_val(keymap->defaults, node->binding);
+}
+
+// The default actions match if their modifiers are held, like before they were in the trie.
+// User keymaps still need the exact modifiers.
+static const KeymapBinding* find_default(Keymap* keymap, unsigned key, GdkModifierType mod)
+{
+  if (keymap->ignore_default || !is_equal(keymap->mode, KEYMAP_DEFAULT_MODE)) {
+    return NULL;
+  }
+  for (unsigned i = 0; i < keymap->defaults->len; i++) {
+    const KeymapBinding* binding = &g_array_index(keymap->defaults, KeymapBinding, i);
+    if (binding->key == key && !(~mod & binding->mod)) {
+      return binding;
+    }
+  }
+  return NULL;
+}
+
+void keymap_set_ignore_default(Keymap* keymap, bool ignore)
+{
+  keymap->ignore_default = ignore;
+}
+
+void keymap_set_timeout(Keymap* keymap, unsigned timeout)
+{
+  keymap->timeout = timeout;
+}
+
+void keymap_set_mode(Keymap* keymap, const char* mode)
 {
-  unsigned key;
-  GdkModifierType mod;
-  gtk_accelerator_parse(accelerator, &key, &mod);
-  if (0 == key && 0 == mod) {
+  if (!mode) {
+    mode = KEYMAP_DEFAULT_MODE;
+  }
+  g_free(keymap->mode);
+  keymap->mode = g_strdup(mode);
+  // the root is kept even if it has no binding so that the pointer stays valid
+  keymap->root = get_root(keymap, mode, true);
+  keymap->pending = NULL;
+}
+
+bool keymap_add_entry(Keymap* keymap, const char* accelerator, const char* mode, int ref)
+{
+  unsigned* keys;
+  GdkModifierType* mods;
+  unsigned count = parse_chord(accelerator, &keys, &mods);
+  if (count == 0) {
+    g_free(keys);
+    g_free(mods);
     return false;
   }
-  bool removed = keymap_remove_entry(keymap, accelerator);
-  KeymapEntry* e = g_malloc0(sizeof(KeymapEntry));
-  e->key = key;
-  e->mod = mod;
-  e->accelerator = g_strdup(accelerator);
-  e->ref = ref;
-  keymap->entries = g_list_append(keymap->entries, e);
-  if (removed) {
-    dd("keymap (%s mod: %x, key: %x) has been overwritten", accelerator, mod, key);
+  // the trie is modified, so the chord in progress may be gone
+  keymap->pending = NULL;
+  KeymapNode* node = get_root(keymap, mode ? mode : KEYMAP_DEFAULT_MODE, true);
+  for (unsigned i = 0; i < count; i++) {
+    node = ensure_child(node, keys[i], mods[i]);
+  }
+  g_free(keys);
+  g_free(mods);
+  if (node->binding.ref != LUA_NOREF) {
+    dd("keymap (%s) has been overwritten", accelerator);
   } else {
-    dd("keymap (%s mod: %x, key: %x) has been newly assined", accelerator, mod, key);
+    dd("keymap (%s) has been newly assined", accelerator);
   }
+  node->binding.ref = ref;
   return true;
 }
 
-bool keymap_remove_entry(Keymap* keymap, const char* accelerator)
+bool keymap_remove_entry(Keymap* keymap, const char* accelerator, const char* mode)
 {
-  for (GList* li = keymap->entries; li != NULL; li = li->next) {
-    KeymapEntry* e = (KeymapEntry*)li->data;
-    if (is_equal(e->accelerator, accelerator)) {
-      keymap->entries = g_list_remove(keymap->entries, e);
-      g_free(e);
-      return true;
+  unsigned* keys;
+  GdkModifierType* mods;
+  unsigned count = parse_chord(accelerator, &keys, &mods);
+  KeymapNode* root = get_root(keymap, mode ? mode : KEYMAP_DEFAULT_MODE, false);
+  bool removed = false;
+  if (count > 0 && root) {
+    KeymapNode* path[count + 1];
+    path[0] = root;
+    unsigned depth = 0;
+    while (depth < count && (path[depth + 1] = get_child(path[depth], keys[depth], mods[depth]))) {
+      depth += 1;
+    }
+    if (depth == count && path[count]->binding.ref != LUA_NOREF) {
+      keymap->pending = NULL;
+      path[count]->binding.ref = LUA_NOREF;
+      // prune the nodes which are no longer needed from the leaf
+      for (unsigned i = count; i > 0 && is_node_empty(path[i]); i--) {
+        gint64 packed = pack(keys[i - 1], mods[i - 1]);
+        g_hash_table_remove(path[i - 1]->children, &packed);
+      }
+      removed = true;
     }
   }
-  return false;
+  g_free(keys);
+  g_free(mods);
+  return removed;
+}
+
+// The binding of `node` if it has its own action.
+static const KeymapBinding* get_action(Keymap* keymap, KeymapNode* node)
+{
+  if (node->binding.ref != LUA_NOREF) {
+    return &node->binding;
+  }
+  if (node->binding.default_id >= 0 && !keymap->ignore_default) {
+    return &node->binding;
+  }
+  return NULL;
 }
 
-bool keymap_perform(Keymap* keymap, lua_State* L, unsigned key, GdkModifierType mod, bool* result, char** error)
+// Returns the binding to perform, or NULL if the key is not bound. `pending` is set if the key
+// is consumed as the prefix of a chord. `prefix` is set to the binding of the pending prefix which
+// has its own action, if the key does not continue it or it has timed out. It is performed first.
+const KeymapBinding* keymap_lookup(Keymap* keymap, unsigned key, GdkModifierType mod, bool* pending, const KeymapBinding** prefix)
+{
+  *pending = false;
+  *prefix = NULL;
+  KeymapNode* node = NULL;
+  if (keymap->pending) {
+    gint64 elapsed = (g_get_monotonic_time() - keymap->pending_since) / 1000;
+    if (keymap->timeout == 0 || elapsed < keymap->timeout) {
+      node = get_child(keymap->pending, key, mod);
+    }
+    if (!node) {
+      *prefix = get_action(keymap, keymap->pending);
+    }
+    keymap->pending = NULL;
+  }
+  if (!node) {
+    node = get_child(keymap->root, key, mod);
+  }
+  if (!node) {
+    // only probed on a miss, so the exact lookup stays one hash lookup
+    return find_default(keymap, key, mod);
+  }
+  if (node->children && g_hash_table_size(node->children) > 0) {
+    keymap->pending = node;
+    keymap->pending_since = g_get_monotonic_time();
+    *pending = true;
+    return NULL;
+  }
+  if (node->binding.ref == LUA_NOREF && keymap->ignore_default) {
+    return NULL;
+  }
+  return &node->binding;
+}
+
+// The binding of the pending prefix if it has its own action, which is performed when the chord
+// times out.
+const KeymapBinding* keymap_get_pending(Keymap* keymap)
+{
+  return keymap->pending ? get_action(keymap, keymap->pending) : NULL;
+}
+
+// Gives up the pending chord and returns the binding to perform instead, if any.
+const KeymapBinding* keymap_expire(Keymap* keymap)
+{
+  const KeymapBinding* binding = keymap_get_pending(keymap);
+  keymap->pending = NULL;
+  return binding;
+}
+
+bool keymap_perform(Keymap* keymap, lua_State* L, const KeymapBinding* binding, bool* result, char** error)
 {
   assert(result);
   assert(error);
-  for (GList* li = keymap->entries; li != NULL; li = li->next) {
-    KeymapEntry* e = (KeymapEntry*)li->data;
-    if (key == e->key && mod == e->mod) {
-      dd("performing keymap: %s (mod: %x, key: %x)", e->accelerator, mod, key);
-      lua_rawgeti(L, LUA_REGISTRYINDEX, e->ref);
-      if (!lua_isfunction(L, -1)) {
-        lua_pop(L, 1); // pop none-function
-        dd("tried to call keymap [%s] which is not function.", e->accelerator);
-        return false;
-      }
-      if (lua_pcall(L, 0, 1, 0) != LUA_OK) {
-        *error = g_strdup(lua_tostring(L, -1));
-        lua_pop(L, 1); // error
-        return false;
-      }
-      *result = lua_toboolean(L, -1);
-      lua_pop(L, 1);
-      return true;
-    }
+  if (binding->ref == LUA_NOREF) {
+    return false;
+  }
+  dd("performing keymap: (mod: %x, key: %x)", binding->mod, binding->key);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, binding->ref);
+  if (!lua_isfunction(L, -1)) {
+    lua_pop(L, 1); // pop none-function
+    dd("tried to call keymap (mod: %x, key: %x) which is not function.", binding->mod, binding->key);
+    return false;
+  }
+  MemoryPhase phase = memory_set_phase(L, MEMORY_PHASE_KEYMAP);
+  int status = coro_run(L, 0, 1);
+  memory_set_phase(L, phase);
+  if (status == LUA_YIELD) {
+    // suspended keymaps do not run the default action
+    *result = false;
+    return true;
   }
-  return false;
+  if (status != LUA_OK) {
+    *error = g_strdup(lua_tostring(L, -1));
+    lua_pop(L, 1); // error
+    return false;
+  }
+  *result = lua_toboolean(L, -1);
+  lua_pop(L, 1);
+  return true;
 }
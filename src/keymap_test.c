@@ -0,0 +1,177 @@
+/**
+ * keymap_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "keymap.h"
+
+
+static const KeymapBinding* press(Keymap* keymap, unsigned key, GdkModifierType mod, bool* pending)
+{
+  const KeymapBinding* prefix = NULL;
+  return keymap_lookup(keymap, key, mod, pending, &prefix);
+}
+
+static void test_single()
+{
+  Keymap* keymap = keymap_init();
+  const GdkModifierType mod = GDK_CONTROL_MASK | GDK_SHIFT_MASK;
+  bool pending = false;
+  keymap_add_default(keymap, GDK_KEY_c, mod, 0);
+
+  const KeymapBinding* b = press(keymap, GDK_KEY_c, mod, &pending);
+  g_assert_nonnull(b);
+  g_assert_false(pending);
+  g_assert_cmpint(b->ref, ==, LUA_NOREF);
+  g_assert_cmpint(b->default_id, ==, 0);
+  g_assert_null(press(keymap, GDK_KEY_c, GDK_CONTROL_MASK, &pending));
+  // the default action also matches with extra modifiers held
+  b = press(keymap, GDK_KEY_c, mod | GDK_MOD1_MASK, &pending);
+  g_assert_nonnull(b);
+  g_assert_cmpint(b->default_id, ==, 0);
+
+  // same binding by a different accelerator
+  g_assert_true(keymap_add_entry(keymap, "<Ctrl><Shift>c", NULL, 10));
+  g_assert_true(keymap_add_entry(keymap, "<Control><Shift>c", NULL, 11));
+  b = press(keymap, GDK_KEY_c, mod, &pending);
+  g_assert_cmpint(b->ref, ==, 11);
+  g_assert_cmpint(b->default_id, ==, 0);
+
+  g_assert_true(keymap_add_entry(keymap, "<Ctrl>a", NULL, 12));
+  g_assert_nonnull(press(keymap, GDK_KEY_a, GDK_CONTROL_MASK, &pending));
+  g_assert_true(keymap_remove_entry(keymap, "<Ctrl>a", NULL));
+  g_assert_false(keymap_remove_entry(keymap, "<Ctrl>a", NULL));
+  g_assert_null(press(keymap, GDK_KEY_a, GDK_CONTROL_MASK, &pending));
+
+  keymap_set_ignore_default(keymap, true);
+  g_assert_nonnull(press(keymap, GDK_KEY_c, mod, &pending));
+  keymap_reset(keymap);
+  // only the default is left and it is ignored
+  g_assert_null(press(keymap, GDK_KEY_c, mod, &pending));
+  keymap_set_ignore_default(keymap, false);
+  b = press(keymap, GDK_KEY_c, mod, &pending);
+  g_assert_cmpint(b->ref, ==, LUA_NOREF);
+
+  g_assert_false(keymap_add_entry(keymap, "<Invalid>", NULL, 13));
+  keymap_close(keymap);
+}
+
+static void test_chord()
+{
+  Keymap* keymap = keymap_init();
+  bool pending = false;
+  g_assert_true(keymap_add_entry(keymap, "<Ctrl>a c", NULL, 20));
+  g_assert_true(keymap_add_entry(keymap, "<Ctrl>a <Ctrl>a", NULL, 21));
+  g_assert_false(keymap_add_entry(keymap, "<Ctrl>a <Invalid>", NULL, 22));
+
+  g_assert_null(press(keymap, GDK_KEY_a, GDK_CONTROL_MASK, &pending));
+  g_assert_true(pending);
+  const KeymapBinding* b = press(keymap, GDK_KEY_c, 0, &pending);
+  g_assert_false(pending);
+  g_assert_cmpint(b->ref, ==, 20);
+
+  // `c` alone is not bound
+  g_assert_null(press(keymap, GDK_KEY_c, 0, &pending));
+  g_assert_false(pending);
+
+  // an unbound key cancels the chord
+  press(keymap, GDK_KEY_a, GDK_CONTROL_MASK, &pending);
+  g_assert_null(press(keymap, GDK_KEY_x, 0, &pending));
+  g_assert_null(press(keymap, GDK_KEY_c, 0, &pending));
+
+  press(keymap, GDK_KEY_a, GDK_CONTROL_MASK, &pending);
+  b = press(keymap, GDK_KEY_a, GDK_CONTROL_MASK, &pending);
+  g_assert_cmpint(b->ref, ==, 21);
+
+  // the prefix is pruned when all of its chords are removed
+  g_assert_true(keymap_remove_entry(keymap, "<Ctrl>a c", NULL));
+  g_assert_true(keymap_remove_entry(keymap, "<Ctrl>a <Ctrl>a", NULL));
+  g_assert_null(press(keymap, GDK_KEY_a, GDK_CONTROL_MASK, &pending));
+  g_assert_false(pending);
+  keymap_close(keymap);
+}
+
+static void test_prefix()
+{
+  Keymap* keymap = keymap_init();
+  const GdkModifierType mod = GDK_CONTROL_MASK | GDK_SHIFT_MASK;
+  bool pending = false;
+  const KeymapBinding* prefix = NULL;
+  keymap_add_default(keymap, GDK_KEY_c, mod, 0);
+  g_assert_true(keymap_add_entry(keymap, "<Ctrl><Shift>c x", NULL, 40));
+  g_assert_true(keymap_add_entry(keymap, "<Ctrl>x", NULL, 41));
+  g_assert_true(keymap_add_entry(keymap, "<Ctrl>x <Shift>c", NULL, 42));
+
+  // the prefix which has the default action waits for the chord
+  g_assert_null(keymap_lookup(keymap, GDK_KEY_c, mod, &pending, &prefix));
+  g_assert_true(pending);
+  g_assert_null(prefix);
+  g_assert_cmpint(keymap_get_pending(keymap)->default_id, ==, 0);
+  const KeymapBinding* b = keymap_lookup(keymap, GDK_KEY_x, 0, &pending, &prefix);
+  g_assert_cmpint(b->ref, ==, 40);
+  g_assert_null(prefix);
+
+  // and acts alone when the next key does not continue it
+  keymap_lookup(keymap, GDK_KEY_c, mod, &pending, &prefix);
+  b = keymap_lookup(keymap, GDK_KEY_y, 0, &pending, &prefix);
+  g_assert_null(b);
+  g_assert_nonnull(prefix);
+  g_assert_cmpint(prefix->default_id, ==, 0);
+
+  // or when the chord times out
+  keymap_lookup(keymap, GDK_KEY_x, GDK_CONTROL_MASK, &pending, &prefix);
+  g_assert_true(pending);
+  b = keymap_expire(keymap);
+  g_assert_cmpint(b->ref, ==, 41);
+  g_assert_null(keymap_get_pending(keymap));
+  g_assert_null(keymap_expire(keymap));
+
+  keymap_lookup(keymap, GDK_KEY_x, GDK_CONTROL_MASK, &pending, &prefix);
+  b = keymap_lookup(keymap, GDK_KEY_c, GDK_SHIFT_MASK, &pending, &prefix);
+  g_assert_cmpint(b->ref, ==, 42);
+  g_assert_null(prefix);
+
+  // a prefix without its own action does nothing
+  g_assert_true(keymap_add_entry(keymap, "<Ctrl>a b", NULL, 43));
+  keymap_lookup(keymap, GDK_KEY_a, GDK_CONTROL_MASK, &pending, &prefix);
+  g_assert_null(keymap_get_pending(keymap));
+  keymap_lookup(keymap, GDK_KEY_z, 0, &pending, &prefix);
+  g_assert_null(prefix);
+  keymap_close(keymap);
+}
+
+static void test_mode()
+{
+  Keymap* keymap = keymap_init();
+  bool pending = false;
+  g_assert_true(keymap_add_entry(keymap, "i", "normal", 30));
+  g_assert_true(keymap_add_entry(keymap, "g g", "normal", 31));
+  g_assert_null(press(keymap, GDK_KEY_i, 0, &pending));
+
+  keymap_set_mode(keymap, "normal");
+  g_assert_cmpstr(keymap->mode, ==, "normal");
+  const KeymapBinding* b = press(keymap, GDK_KEY_i, 0, &pending);
+  g_assert_cmpint(b->ref, ==, 30);
+  press(keymap, GDK_KEY_g, 0, &pending);
+  g_assert_true(pending);
+  b = press(keymap, GDK_KEY_g, 0, &pending);
+  g_assert_cmpint(b->ref, ==, 31);
+
+  keymap_set_mode(keymap, NULL);
+  g_assert_cmpstr(keymap->mode, ==, KEYMAP_DEFAULT_MODE);
+  g_assert_null(press(keymap, GDK_KEY_i, 0, &pending));
+  keymap_close(keymap);
+}
+
+void test_keymap()
+{
+  test_single();
+  test_chord();
+  test_prefix();
+  test_mode();
+}
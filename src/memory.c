@@ -0,0 +1,152 @@
+/**
+ * memory.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "memory.h"
+
+
+static const char* MEMORY_PHASE_NAMES[MEMORY_PHASE_COUNT] = {
+  [MEMORY_PHASE_OTHER] = "other",
+  [MEMORY_PHASE_CONFIG] = "config",
+  [MEMORY_PHASE_THEME] = "theme",
+  [MEMORY_PHASE_HOOK] = "hook",
+  [MEMORY_PHASE_KEYMAP] = "keymap",
+  [MEMORY_PHASE_TIMER] = "timer",
+  [MEMORY_PHASE_TASK] = "task",
+};
+
+Memory* memory_init()
+{
+  return g_malloc0(sizeof(Memory));
+}
+
+// Must be called after `lua_close()`.
+void memory_close(Memory* memory)
+{
+  g_free(memory);
+}
+
+// `osize` is the size of the block when `ptr` is not NULL, and the type of the new object otherwise.
+static void* memory_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+  Memory* memory = (Memory*)ud;
+  size_t old = ptr ? osize : 0;
+  MemoryCount* count = &memory->counts[memory->phase];
+  if (nsize == 0) {
+    free(ptr);
+    memory->used -= old;
+    count->freed += old;
+    return NULL;
+  }
+  // Shrinking must not fail, and Lua collects garbage and tries again when growing fails. Outside
+  // protected calls the error would reach the panic handler, so the usage can go over the limit there.
+  if (memory->limit && memory->depth && nsize > old && memory->used - old + nsize > memory->limit) {
+    memory->refused += 1;
+    return NULL;
+  }
+  void* block = realloc(ptr, nsize);
+  if (!block) {
+    return NULL;
+  }
+  memory->used = memory->used - old + nsize;
+  count->freed += old;
+  count->allocated += nsize;
+  if (memory->used > memory->peak) {
+    memory->peak = memory->used;
+  }
+  return block;
+}
+
+static int memory_panic(lua_State* L)
+{
+  g_warning("Unprotected error in Lua: %s", lua_tostring(L, -1));
+  return 0; // abort
+}
+
+// Same as `luaL_newstate()` except that the allocations are counted by `memory`.
+lua_State* memory_new_state(Memory* memory)
+{
+  lua_State* L = lua_newstate(memory_alloc, memory);
+  if (L) {
+    lua_atpanic(L, memory_panic);
+  }
+  return L;
+}
+
+// Returns NULL if `L` is not made by `memory_new_state()`.
+Memory* memory_get(lua_State* L)
+{
+  void* ud = NULL;
+  if (lua_getallocf(L, &ud) != memory_alloc) {
+    return NULL;
+  }
+  return (Memory*)ud;
+}
+
+const char* memory_get_phase_name(MemoryPhase phase)
+{
+  return MEMORY_PHASE_NAMES[phase];
+}
+
+// Returns the previous phase to be restored.
+MemoryPhase memory_set_phase(lua_State* L, MemoryPhase phase)
+{
+  Memory* memory = memory_get(L);
+  if (!memory) {
+    return MEMORY_PHASE_OTHER;
+  }
+  MemoryPhase prev = memory->phase;
+  memory->phase = phase;
+  return prev;
+}
+
+// The limit lower than the current usage takes effect as the garbage is collected.
+void memory_set_limit(Memory* memory, size_t limit)
+{
+  memory->limit = limit;
+}
+
+// Marks the start of a protected call (`lua_pcall()` or `lua_resume()`), in which the refused allocation
+// is raised as an error caught by the caller.
+void memory_enter(lua_State* L)
+{
+  Memory* memory = memory_get(L);
+  if (memory) {
+    memory->depth += 1;
+  }
+}
+
+void memory_leave(lua_State* L)
+{
+  Memory* memory = memory_get(L);
+  if (memory) {
+    assert(memory->depth > 0);
+    memory->depth -= 1;
+  }
+}
+
+// For a nested main loop, where the callbacks push values outside of any protected call.
+// Returns the depth to be restored.
+unsigned memory_suspend(lua_State* L)
+{
+  Memory* memory = memory_get(L);
+  if (!memory) {
+    return 0;
+  }
+  unsigned depth = memory->depth;
+  memory->depth = 0;
+  return depth;
+}
+
+void memory_restore(lua_State* L, unsigned depth)
+{
+  Memory* memory = memory_get(L);
+  if (memory) {
+    memory->depth = depth;
+  }
+}
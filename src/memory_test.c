@@ -0,0 +1,70 @@
+/**
+ * memory_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "memory.h"
+#include "hook.h"
+
+
+void test_memory()
+{
+  Memory* memory = memory_init();
+  lua_State* L = memory_new_state(memory);
+  luaL_openlibs(L);
+  g_assert_true(memory_get(L) == memory);
+  g_assert_cmpuint(memory->used, >, 0);
+  g_assert_cmpuint(memory->used, ==, lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0));
+
+  MemoryPhase prev = memory_set_phase(L, MEMORY_PHASE_CONFIG);
+  g_assert_cmpint(prev, ==, MEMORY_PHASE_OTHER);
+  g_assert_cmpint(luaL_dostring(L, "t = {} for i = 1, 1000 do t[i] = tostring(i) end"), ==, LUA_OK);
+  memory_set_phase(L, prev);
+  g_assert_cmpuint(memory->counts[MEMORY_PHASE_CONFIG].allocated, >, 1000);
+  g_assert_cmpuint(memory->counts[MEMORY_PHASE_HOOK].allocated, ==, 0);
+
+  memory_set_limit(memory, memory->used + 64 * 1024);
+  // not enforced outside protected calls
+  g_assert_cmpint(luaL_dostring(L, "t = {} for i = 1, 1e4 do t[i] = {} end t = nil"), ==, LUA_OK);
+  g_assert_cmpuint(memory->refused, ==, 0);
+  lua_gc(L, LUA_GCCOLLECT, 0);
+
+  memory_enter(L);
+  g_assert_cmpint(luaL_dostring(L, "t = {} for i = 1, 1e6 do t[i] = {} end"), ==, LUA_ERRMEM);
+  memory_leave(L);
+  lua_pop(L, 1);
+  g_assert_cmpuint(memory->refused, >, 0);
+  g_assert_cmpuint(memory->used, <=, memory->limit);
+
+  // a hook is dispatched while the memory is full, and only its own allocations fail
+  Hook* hook = hook_init();
+  luaL_dostring(L, "return function(title) s = title .. title end");
+  hook_add(hook, HOOK_TITLE, luaL_ref(L, LUA_REGISTRYINDEX), 0, NULL);
+  char* title = g_strnfill(memory->limit, 'x');
+  bool result = false;
+  g_assert_false(hook_perform_title(hook, L, title, &result));
+  g_assert_cmpint(lua_gettop(L), ==, 0);
+  g_free(title);
+  hook_close(hook);
+
+  // usable again once the garbage is collected
+  lua_pushnil(L);
+  lua_setglobal(L, "t");
+  lua_gc(L, LUA_GCCOLLECT, 0);
+  g_assert_cmpint(luaL_dostring(L, "return 1"), ==, LUA_OK);
+  lua_pop(L, 1);
+  g_assert_cmpuint(memory->peak, >=, memory->used);
+
+  lua_State* other = luaL_newstate();
+  g_assert_null(memory_get(other));
+  lua_close(other);
+
+  lua_close(L);
+  g_assert_cmpuint(memory->used, ==, 0);
+  memory_close(memory);
+}
@@ -9,6 +9,7 @@
 
 #include "meta.h"
 #include "property.h"
+#include "meta-hash.h"
 
 
 static char* get_default_shell()
@@ -24,197 +25,249 @@ static char* get_default_shell()
   return g_strdup(TYM_FALL_BACK_SHELL);
 }
 
-static void free_entry(void* data)
-{
-  g_free(((MetaEntry*)data)->default_value);
-  g_free(data);
-}
-
-int entries_sort_func(const void* a, const void* b)
-{
-  return ((MetaEntry*)a)->index - ((MetaEntry*)b)->index;
-}
-
-Meta* meta_init()
-{
-  Meta* meta = g_malloc0(sizeof(Meta));
 #define	CB(f) ((MetaCallback) (f))
+#define T_INT META_ENTRY_TYPE_INTEGER
+#define T_BOOL META_ENTRY_TYPE_BOOLEAN
+#define T_NONE META_ENTRY_TYPE_NONE
+#define entry(key, ...) \
+  [META_KEY_##key] = { .name=#key, .index=META_KEY_##key, __VA_ARGS__ }
 #define color_special(key, default_color) \
-  { \
-    .name=("color_"#key ), .default_value=sdup(default_color), .arg_desc="", .desc=("value of color_"#key), \
-     .is_theme=true, .setter=CB(setter_color_##key) \
-  }
+  entry( \
+    color_##key, .default_value=(default_color), .arg_desc="", .desc=("value of color_"#key), \
+    .is_theme=true, .setter=CB(setter_color_##key) \
+  )
 #define color_normal(i) \
-  { \
-    .name=("color_"#i ), .default_value=sdup(TYM_DEFAULT_COLOR_##i), .arg_desc="", .desc=("value of color_"#i), \
+  entry( \
+    color_##i, .default_value=TYM_DEFAULT_COLOR_##i, .arg_desc="", .desc=("value of color_"#i), \
     .option_flag=G_OPTION_FLAG_HIDDEN, .is_theme=true, .setter=CB(setter_color_normal) \
-  }
-  const MetaEntryType T_INT = META_ENTRY_TYPE_INTEGER;
-  const MetaEntryType T_BOOL = META_ENTRY_TYPE_BOOLEAN;
-  const MetaEntryType T_NONE = META_ENTRY_TYPE_NONE;
+  )
 
-  char* (*sdup)(const char*) = g_strdup;
-  void* (*mdup)(const void*, unsigned) = g_memdup;
-  const bool v_false = false;
-  const int v_zero = 0;
+static const bool v_false = false;
+static const int v_zero = 0;
 
-  MetaEntry ee[] = {
-    // STR
-    {
-      .name="shell",  .short_name='e', .default_value=get_default_shell(), .arg_desc="<shell>",
-      .desc="Shell to use in the terminal",
-      .setter=CB(setter_shell)
-    },
-    {
-      .name="term", .default_value=sdup(TYM_DEFAULT_TERM), .arg_desc="", .desc="Value to override $TERM",
-      .setter=CB(setter_term)
-    },
-    {
-      .name="title", .default_value=sdup(TYM_DEFAULT_TITLE), .arg_desc="", .desc="Window title",
-      .getter=CB(getter_title), .setter=CB(setter_title)
-    },
-    {
-      .name="font", .default_value=sdup(""), .arg_desc="", .desc="Font to render(e.g. 'Ubuntu Mono 12')",
-      .setter=CB(setter_font)
-    },
-    {
-      .name="icon", .default_value=sdup(TYM_DEFAULT_ICON), .arg_desc="", .desc="Name of window icon",
-      .setter=CB(setter_icon)
-    },
-    {
-      .name="role", .default_value=sdup(""), .arg_desc="",
-      .desc="Unique identifier for the window",
-      .getter=CB(getter_role), .setter=CB(setter_role),
-    },
-    {
-      .name="cursor_shape", .default_value=sdup(TYM_DEFAULT_CURSOR_SHAPE), .arg_desc="",
-      .desc="'" TYM_CURSOR_SHAPE_BLOCK "', '" TYM_CURSOR_SHAPE_IBEAM "' or '" TYM_CURSOR_SHAPE_UNDERLINE "'",
-      .getter=CB(getter_cursor_shape), .setter=CB(setter_cursor_shape),
-    },
-    {
-      .name="cursor_blink_mode", .default_value=sdup(TYM_DEFAULT_CURSOR_BLINK_MODE), .arg_desc="",
-      .desc="'" TYM_CURSOR_BLINK_MODE_SYSTEM "', '" TYM_CURSOR_BLINK_MODE_ON "' or '" TYM_CURSOR_BLINK_MODE_OFF "'",
-      .getter=CB(getter_cursor_blink_mode), .setter=CB(setter_cursor_blink_mode),
-    },
-    {
-      .name="cjk_width", .arg_desc="", .default_value=sdup(TYM_DEFAULT_CJK),
-      .desc="'" TYM_CJK_WIDTH_NARROW "' or '" TYM_CJK_WIDTH_WIDE "'",
-      .getter=CB(getter_cjk_width), .setter=CB(setter_cjk_width),
-    },
-    {
-      .name="background_image", .arg_desc="", .default_value=sdup(""),
-      .desc="path to background image",
-      .setter=CB(setter_background_image),
-    },
-    {
-      .name="uri_schemes", .arg_desc="", .default_value=sdup(TYM_DEFAULT_URI_SCHEMES),
-      .desc="URI schemes to be highlighted and clickable",
-      .setter=CB(setter_uri_schemes),
-    },
-    // INT
-    {
-      .name="width", .type=T_INT, .default_value=mdup(&TYM_DEFAULT_WIDTH, sizeof(int)),
-      .arg_desc="<int>", .desc="Initial columns",
-      .getter=CB(getter_width), .setter=CB(setter_width)
-    },
-    {
-      .name="height", .type=T_INT, .default_value=mdup(&TYM_DEFAULT_HEIGHT, sizeof(int)),
-      .arg_desc="<int>", .desc="Initial rows",
-      .getter=CB(getter_height), .setter=CB(setter_height)
-    },
-    {
-      .name="scale", .type=T_INT, .default_value=mdup(&TYM_DEFAULT_SCALE, sizeof(int)),
-      .arg_desc="<int>", .desc="Font scale in percent",
-      .getter=CB(getter_scale), .setter=CB(setter_scale)
-    },
-    {
-      .name="padding_horizontal", .type=T_INT, .default_value=mdup(&v_zero, sizeof(int)),
-      .arg_desc="<int>", .desc="Horizontal padding",
-      .setter=CB(setter_padding_horizontal)
-    },
-    {
-      .name="padding_vertical", .type=T_INT, .default_value=mdup(&v_zero, sizeof(int)),
-      .arg_desc="<int>", .desc="Vertical padding",
-      .setter=CB(setter_padding_vertical)
-    },
-    {
-      .name="scrollback_length", .type=T_INT, .default_value=mdup(&TYM_DEFAULT_SCROLLBACK, sizeof(int)),
-      .arg_desc="<int>", .desc="Scrollback buffer length",
-      .getter=CB(getter_scrollback_length), .setter=CB(setter_scrollback_length)
-    },
-    // BOOL
-    {
-      .name="ignore_default_keymap", .type=T_BOOL, .default_value=mdup(&v_false, sizeof(bool)),
-      .desc="Whether to use default keymap",
-    },
-    {
-      .name="autohide", .type=T_BOOL, .default_value=mdup(&v_false, sizeof(bool)),
-      .desc="Whether to hide mouse cursor when key is pressed",
-      .getter=CB(getter_autohide), .setter=CB(setter_autohide)
-    },
-    {
-      .name="silent", .type=T_BOOL, .default_value=mdup(&v_false, sizeof(bool)),
-      .desc="Whether to beep when bell sequence is sent",
-      .getter=CB(getter_silent), .setter=CB(setter_silent),
-    },
-    color_normal(0),  color_normal(1),  color_normal(2),  color_normal(3),
-    color_normal(4),  color_normal(5),  color_normal(6),  color_normal(7),
-    color_normal(8),  color_normal(9),  color_normal(10), color_normal(11),
-    color_normal(12), color_normal(13), color_normal(14), color_normal(15),
-    color_special(window_background, ""),
-    color_special(background, TYM_DEFAULT_COLOR_BACKGROUND),
-    color_special(foreground, TYM_DEFAULT_COLOR_FOREGROUND),
-    color_special(bold, TYM_DEFAULT_COLOR_FOREGROUND),
-    color_special(cursor, TYM_DEFAULT_COLOR_FOREGROUND),
-    color_special(cursor_foreground, TYM_DEFAULT_COLOR_BACKGROUND),
-    color_special(highlight, TYM_DEFAULT_COLOR_FOREGROUND),
-    color_special(highlight_foreground, TYM_DEFAULT_COLOR_BACKGROUND),
-    {
-      .name="color_0..15", .type=T_NONE, .arg_desc="", .desc="value of color_0 .. color_15",
-    },
-  };
+static const MetaEntry META_ENTRIES[] = {
+  // STR
+  entry(
+    shell, .short_name='e', .arg_desc="<shell>",
+    .desc="Shell to use in the terminal",
+    .setter=CB(setter_shell)
+  ),
+  entry(
+    term, .default_value=TYM_DEFAULT_TERM, .arg_desc="", .desc="Value to override $TERM",
+    .setter=CB(setter_term)
+  ),
+  entry(
+    title, .default_value=TYM_DEFAULT_TITLE, .arg_desc="", .desc="Window title",
+    .getter=CB(getter_title), .setter=CB(setter_title)
+  ),
+  entry(
+    font, .default_value="", .arg_desc="", .desc="Font to render(e.g. 'Ubuntu Mono 12')",
+    .setter=CB(setter_font)
+  ),
+  entry(
+    icon, .default_value=TYM_DEFAULT_ICON, .arg_desc="", .desc="Name of window icon",
+    .setter=CB(setter_icon)
+  ),
+  entry(
+    role, .default_value="", .arg_desc="",
+    .desc="Unique identifier for the window",
+    .getter=CB(getter_role), .setter=CB(setter_role),
+  ),
+  entry(
+    cursor_shape, .default_value=TYM_DEFAULT_CURSOR_SHAPE, .arg_desc="",
+    .desc="'" TYM_CURSOR_SHAPE_BLOCK "', '" TYM_CURSOR_SHAPE_IBEAM "' or '" TYM_CURSOR_SHAPE_UNDERLINE "'",
+    .getter=CB(getter_cursor_shape), .setter=CB(setter_cursor_shape),
+  ),
+  entry(
+    cursor_blink_mode, .default_value=TYM_DEFAULT_CURSOR_BLINK_MODE, .arg_desc="",
+    .desc="'" TYM_CURSOR_BLINK_MODE_SYSTEM "', '" TYM_CURSOR_BLINK_MODE_ON "' or '" TYM_CURSOR_BLINK_MODE_OFF "'",
+    .getter=CB(getter_cursor_blink_mode), .setter=CB(setter_cursor_blink_mode),
+  ),
+  entry(
+    cjk_width, .arg_desc="", .default_value=TYM_DEFAULT_CJK,
+    .desc="'" TYM_CJK_WIDTH_NARROW "' or '" TYM_CJK_WIDTH_WIDE "'",
+    .getter=CB(getter_cjk_width), .setter=CB(setter_cjk_width),
+  ),
+  entry(
+    background_image, .arg_desc="", .default_value="",
+    .desc="path to background image",
+    .setter=CB(setter_background_image),
+  ),
+  entry(
+    uri_schemes, .arg_desc="", .default_value=TYM_DEFAULT_URI_SCHEMES,
+    .desc="URI schemes to be highlighted and clickable",
+    .setter=CB(setter_uri_schemes),
+  ),
+  entry(
+    gc_mode, .arg_desc="", .default_value=TYM_DEFAULT_GC_MODE,
+    .desc="'" TYM_GC_MODE_INCREMENTAL "' or '" TYM_GC_MODE_GENERATIONAL "' (Lua 5.4 only)",
+    .setter=CB(setter_gc_mode),
+  ),
+  // INT
+  entry(
+    width, .type=T_INT, .default_value=&TYM_DEFAULT_WIDTH,
+    .arg_desc="<int>", .desc="Initial columns",
+    .getter=CB(getter_width), .setter=CB(setter_width)
+  ),
+  entry(
+    height, .type=T_INT, .default_value=&TYM_DEFAULT_HEIGHT,
+    .arg_desc="<int>", .desc="Initial rows",
+    .getter=CB(getter_height), .setter=CB(setter_height)
+  ),
+  entry(
+    scale, .type=T_INT, .default_value=&TYM_DEFAULT_SCALE,
+    .arg_desc="<int>", .desc="Font scale in percent",
+    .getter=CB(getter_scale), .setter=CB(setter_scale)
+  ),
+  entry(
+    padding_horizontal, .type=T_INT, .default_value=&v_zero,
+    .arg_desc="<int>", .desc="Horizontal padding",
+    .setter=CB(setter_padding_horizontal)
+  ),
+  entry(
+    padding_vertical, .type=T_INT, .default_value=&v_zero,
+    .arg_desc="<int>", .desc="Vertical padding",
+    .setter=CB(setter_padding_vertical)
+  ),
+  entry(
+    scrollback_length, .type=T_INT, .default_value=&TYM_DEFAULT_SCROLLBACK,
+    .arg_desc="<int>", .desc="Scrollback buffer length",
+    .getter=CB(getter_scrollback_length), .setter=CB(setter_scrollback_length)
+  ),
+  entry(
+    keymap_timeout, .type=T_INT, .default_value=&TYM_DEFAULT_KEYMAP_TIMEOUT,
+    .arg_desc="<int>", .desc="Milliseconds to wait for the next key of a chord",
+    .setter=CB(setter_keymap_timeout)
+  ),
+  entry(
+    coalesce_interval, .type=T_INT, .default_value=&TYM_DEFAULT_COALESCE_INTERVAL,
+    .arg_desc="<int>", .desc="Milliseconds to gather title changes and bells",
+  ),
+  entry(
+    selection_debounce, .type=T_INT, .default_value=&TYM_DEFAULT_SELECTION_DEBOUNCE,
+    .arg_desc="<int>", .desc="Milliseconds the selection has to settle before the selection hooks",
+  ),
+  entry(
+    timer_slack, .type=T_INT, .default_value=&TYM_DEFAULT_TIMER_SLACK,
+    .arg_desc="<int>", .desc="Milliseconds timeouts may be delayed to run together",
+    .setter=CB(setter_timer_slack)
+  ),
+  entry(
+    lua_time_budget, .type=T_INT, .default_value=&TYM_DEFAULT_LUA_TIME_BUDGET,
+    .arg_desc="<int>", .desc="Milliseconds a hook, keymap or timeout can run before it is aborted",
+    .setter=CB(setter_lua_time_budget)
+  ),
+  entry(
+    lua_instruction_budget, .type=T_INT, .default_value=&v_zero,
+    .arg_desc="<int>", .desc="Lua instructions a hook, keymap or timeout can run before it is aborted",
+    .setter=CB(setter_lua_instruction_budget)
+  ),
+  entry(
+    lua_memory_limit, .type=T_INT, .default_value=&TYM_DEFAULT_LUA_MEMORY_LIMIT,
+    .arg_desc="<int>", .desc="Megabytes of memory Lua can use",
+    .setter=CB(setter_lua_memory_limit)
+  ),
+  entry(
+    gc_idle_delay, .type=T_INT, .default_value=&TYM_DEFAULT_GC_IDLE_DELAY,
+    .arg_desc="<int>", .desc="Milliseconds without input before Lua collects garbage",
+    .setter=CB(setter_gc_idle_delay)
+  ),
+  entry(
+    gc_pause, .type=T_INT, .default_value=&v_zero,
+    .arg_desc="<int>", .desc="Pause of the garbage collector of Lua in percent",
+    .setter=CB(setter_gc_pause)
+  ),
+  entry(
+    gc_step_multiplier, .type=T_INT, .default_value=&v_zero,
+    .arg_desc="<int>", .desc="Step multiplier of the garbage collector of Lua in percent",
+    .setter=CB(setter_gc_step_multiplier)
+  ),
+  // BOOL
+  entry(
+    ignore_default_keymap, .type=T_BOOL, .default_value=&v_false,
+    .desc="Whether to use default keymap",
+    .setter=CB(setter_ignore_default_keymap)
+  ),
+  entry(
+    autohide, .type=T_BOOL, .default_value=&v_false,
+    .desc="Whether to hide mouse cursor when key is pressed",
+    .getter=CB(getter_autohide), .setter=CB(setter_autohide)
+  ),
+  entry(
+    silent, .type=T_BOOL, .default_value=&v_false,
+    .desc="Whether to beep when bell sequence is sent",
+    .getter=CB(getter_silent), .setter=CB(setter_silent),
+  ),
+  entry(
+    coalesce_scroll, .type=T_BOOL, .default_value=&v_false,
+    .desc="Whether to call the scroll hook once per frame with summed deltas",
+  ),
+  color_normal(0),  color_normal(1),  color_normal(2),  color_normal(3),
+  color_normal(4),  color_normal(5),  color_normal(6),  color_normal(7),
+  color_normal(8),  color_normal(9),  color_normal(10), color_normal(11),
+  color_normal(12), color_normal(13), color_normal(14), color_normal(15),
+  color_special(window_background, ""),
+  color_special(background, TYM_DEFAULT_COLOR_BACKGROUND),
+  color_special(foreground, TYM_DEFAULT_COLOR_FOREGROUND),
+  color_special(bold, TYM_DEFAULT_COLOR_FOREGROUND),
+  color_special(cursor, TYM_DEFAULT_COLOR_FOREGROUND),
+  color_special(cursor_foreground, TYM_DEFAULT_COLOR_BACKGROUND),
+  color_special(highlight, TYM_DEFAULT_COLOR_FOREGROUND),
+  color_special(highlight_foreground, TYM_DEFAULT_COLOR_BACKGROUND),
+  // only shown in help
+  [META_KEY_COUNT] = {
+    .name="color_0..15", .index=META_KEY_COUNT, .type=T_NONE, .arg_desc="", .desc="value of color_0 .. color_15",
+  },
+};
 #undef CB
-#undef get_default_color
+#undef T_INT
+#undef T_BOOL
+#undef T_NONE
+#undef entry
 #undef color_special
 #undef color_normal
 
-  meta->data = g_hash_table_new_full(
-    g_str_hash,
-    g_str_equal,
-    NULL,
-    (GDestroyNotify)free_entry
-  );
+Meta* meta_init()
+{
+  Meta* meta = g_malloc0(sizeof(Meta));
+  meta->entries = META_ENTRIES;
+  meta->default_shell = get_default_shell();
   unsigned i = 0;
-  unsigned len = sizeof(ee) / sizeof(MetaEntry);
-  while (i < len) {
-    MetaEntry* entry = (MetaEntry*)g_memdup(&ee[i], sizeof(ee[i]));
-    if (entry->getter && !entry->setter) {
-      dw("Invalid meta `%s`: setter is provided but getter is not provided.", entry->name);
+  while (i < META_KEY_COUNT) {
+    const MetaEntry* e = &META_ENTRIES[i];
+    if (e->getter && !e->setter) {
+      dw("Invalid meta `%s`: setter is provided but getter is not provided.", e->name);
     }
-    entry->index = i;
-    g_hash_table_insert(meta->data, entry->name, entry);
-    meta->list = g_list_insert_sorted(meta->list, entry, entries_sort_func);
+    meta->defaults[i] = e->default_value;
     i++;
   }
+  meta->defaults[META_KEY_shell] = meta->default_shell;
   return meta;
 }
 
 void meta_close(Meta* meta)
 {
-  g_hash_table_destroy(meta->data);
-  g_list_free(meta->list);
+  g_free(meta->default_shell);
   g_free(meta);
 }
 
 unsigned meta_size(Meta* meta)
 {
-  return g_hash_table_size(meta->data);
+  return G_N_ELEMENTS(META_ENTRIES);
 }
 
-MetaEntry* meta_get_entry(Meta* meta, const char* key)
+const MetaEntry* meta_get_entry(Meta* meta, const char* key)
 {
-  MetaEntry* entry = (MetaEntry*)g_hash_table_lookup(meta->data, key);
-  if (!entry) {
+  if (!key) {
+    return NULL;
+  }
+  int index = META_HASH_SLOTS[schema_hash(key, META_HASH_SEED) & (META_HASH_SIZE - 1)];
+  if (index < 0) {
+    return NULL;
+  }
+  const MetaEntry* entry = &META_ENTRIES[index];
+  // the hash is perfect only for known keys, so unknown ones still need to be rejected
+  if (!is_equal(entry->name, key)) {
     return NULL;
   }
   MetaEntryType t = entry->type;
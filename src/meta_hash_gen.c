@@ -0,0 +1,64 @@
+/**
+ * meta_hash_gen.c
+ *
+ * Generates `meta-hash.h`, the perfect hash from config keys to MetaEntry->index.
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "schema.h"
+
+
+static const char* KEYS[] = {
+#define X(key) #key,
+  TYM_META_KEYS(X)
+#undef X
+};
+
+int main(int argc, char* argv[])
+{
+  const unsigned count = sizeof(KEYS) / sizeof(KEYS[0]);
+  // a sparse table keeps the search for a collision-free seed short
+  unsigned size = 1;
+  while (size < count * 4) {
+    size <<= 1;
+  }
+  int* slots = malloc(sizeof(int) * size);
+  unsigned seed = 0;
+  while (true) {
+    for (unsigned i = 0; i < size; i++) {
+      slots[i] = -1;
+    }
+    unsigned i = 0;
+    while (i < count) {
+      unsigned slot = schema_hash(KEYS[i], seed) & (size - 1);
+      if (slots[slot] >= 0) {
+        break;
+      }
+      slots[slot] = i;
+      i++;
+    }
+    if (i == count) {
+      break;
+    }
+    seed++;
+  }
+
+  printf("/* Generated by meta-hash-gen from schema.h. Do not edit. */\n\n");
+  printf("#define META_HASH_SEED %uu\n", seed);
+  printf("#define META_HASH_SIZE %uu\n\n", size);
+  printf("static const short META_HASH_SLOTS[META_HASH_SIZE] = {");
+  for (unsigned i = 0; i < size; i++) {
+    printf("%s%d,", i % 16 == 0 ? "\n  " : " ", slots[i]);
+  }
+  printf("\n};\n");
+  free(slots);
+  return 0;
+}
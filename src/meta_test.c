@@ -0,0 +1,31 @@
+/**
+ * meta_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "schema.h"
+#include "meta-hash.h"
+
+
+#define KEY_NAME(key) #key,
+static const char* KEYS[] = { TYM_META_KEYS(KEY_NAME) };
+#undef KEY_NAME
+
+static int lookup(const char* key)
+{
+  return META_HASH_SLOTS[schema_hash(key, META_HASH_SEED) & (META_HASH_SIZE - 1)];
+}
+
+void test_meta()
+{
+  for (unsigned i = 0; i < G_N_ELEMENTS(KEYS); i++) {
+    g_assert_cmpint(lookup(KEYS[i]), ==, i);
+  }
+  int index = lookup("no_such_key");
+  g_assert_true(index < 0 || g_strcmp0(KEYS[index], "no_such_key") != 0);
+}
@@ -9,6 +9,7 @@
 
 #include "option.h"
 #include "meta.h"
+#include "profile.h"
 
 
 Option* option_init(Meta* meta)
@@ -21,7 +22,6 @@ Option* option_init(Meta* meta)
       .short_name = 'v',
       .flags = G_OPTION_FLAG_NONE,
       .arg = G_OPTION_ARG_NONE,
-      .arg_data = &option->version,
       .description = "Show version",
       .arg_description = NULL,
     }, {
@@ -29,7 +29,6 @@ Option* option_init(Meta* meta)
       .short_name = 'u',
       .flags = G_OPTION_FLAG_NONE,
       .arg = G_OPTION_ARG_STRING,
-      .arg_data = &option->config_path,
       .description = "<path> to config file. Set '" TYM_SYMBOL_NONE "' to start without loading config",
       .arg_description = "<path>",
     }, {
@@ -37,7 +36,6 @@ Option* option_init(Meta* meta)
       .short_name = 't',
       .flags = G_OPTION_FLAG_NONE,
       .arg = G_OPTION_ARG_STRING,
-      .arg_data = &option->theme_path,
       .description = "<path> to theme file. Set '" TYM_SYMBOL_NONE "' to start without loading theme",
       .arg_description = "<path>",
     }, {
@@ -45,15 +43,30 @@ Option* option_init(Meta* meta)
       .short_name = 's',
       .flags = G_OPTION_FLAG_NONE,
       .arg = G_OPTION_ARG_STRING,
-      .arg_data = &option->signal,
       .description = "Signal to send via D-Bus",
       .arg_description = "<signal>",
     }, {
       .long_name = "nolua",
       .flags = G_OPTION_FLAG_NONE,
       .arg = G_OPTION_ARG_NONE,
-      .arg_data = &option->nolua,
       .description = "Launch without Lua context",
+    }, {
+      .long_name = "daemon",
+      .short_name = 'd',
+      .flags = G_OPTION_FLAG_NONE,
+      .arg = G_OPTION_ARG_NONE,
+      .description = "Open the window in the running tym instance (the first one becomes the instance)",
+    }, {
+      .long_name = "no-bytecode-cache",
+      .flags = G_OPTION_FLAG_NONE,
+      .arg = G_OPTION_ARG_NONE,
+      .description = "Load config and theme without the cache of compiled Lua chunks",
+    }, {
+      .long_name = "profile-startup",
+      .flags = G_OPTION_FLAG_NONE,
+      .arg = G_OPTION_ARG_STRING,
+      .description = "Print how long each startup phase took on exit as '" TYM_PROFILE_FORMAT_TABLE "' or '" TYM_PROFILE_FORMAT_JSON "'",
+      .arg_description = "<format>",
     }
   };
 
@@ -63,8 +76,9 @@ Option* option_init(Meta* meta)
   memmove(options_entries, app_options, sizeof(app_options));
   unsigned i = sizeof(app_options) / sizeof(GOptionEntry);
 
-  for (GList* li = meta->list; li != NULL; li = li->next) {
-    MetaEntry* me = (MetaEntry*)li->data;
+  // built from the static table of meta, so names and descriptions are not copied
+  for (unsigned j = 0; j < meta_size(meta); j++) {
+    const MetaEntry* me = &meta->entries[j];
     GOptionEntry* e = &options_entries[i];
     i += 1;
     e->long_name = me->name;
@@ -95,6 +109,10 @@ void option_close(Option* option)
   if (option->values) {
     g_variant_dict_unref(option->values);
   }
+  g_free(option->config_path);
+  g_free(option->theme_path);
+  g_free(option->signal);
+  g_free(option->profile_startup);
   g_free(option->entries);
   g_free(option);
 }
@@ -111,6 +129,19 @@ void option_load_from_cli(Option* option, GApplicationCommandLine* cli)
     g_variant_dict_unref(option->values);
   }
   option->values = g_variant_dict_ref(values);
+
+  // App options are not bound to `arg_data` so that they are forwarded to the primary instance in daemon mode.
+  g_clear_pointer(&option->config_path, g_free);
+  g_clear_pointer(&option->theme_path, g_free);
+  g_clear_pointer(&option->signal, g_free);
+  g_clear_pointer(&option->profile_startup, g_free);
+  g_variant_dict_lookup(values, "use", "s", &option->config_path);
+  g_variant_dict_lookup(values, "theme", "s", &option->theme_path);
+  g_variant_dict_lookup(values, "signal", "s", &option->signal);
+  g_variant_dict_lookup(values, "profile-startup", "s", &option->profile_startup);
+  option->version = g_variant_dict_contains(values, "version");
+  option->nolua = g_variant_dict_contains(values, "nolua");
+  option->no_bytecode_cache = g_variant_dict_contains(values, "no-bytecode-cache");
 }
 
 bool option_get_str_value(Option* option, const char* key, const char** value)
@@ -172,7 +203,17 @@ char* option_get_signal(Option* option)
   return option->signal;
 }
 
+char* option_get_profile_startup(Option* option)
+{
+  return option->profile_startup;
+}
+
 bool option_get_nolua(Option* option)
 {
   return option->nolua;
 }
+
+bool option_get_no_bytecode_cache(Option* option)
+{
+  return option->no_bytecode_cache;
+}
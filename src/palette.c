@@ -0,0 +1,47 @@
+/**
+ * palette.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "palette.h"
+
+
+Palette* palette_init()
+{
+  Palette* palette = g_malloc0(sizeof(Palette));
+  // VTE has its own palette until the first upload
+  palette->dirty = true;
+  return palette;
+}
+
+void palette_close(Palette* palette)
+{
+  g_free(palette);
+}
+
+bool palette_set_color(Palette* palette, unsigned index, const char* value)
+{
+  g_return_val_if_fail(index < PALETTE_SIZE, false);
+  GdkRGBA color = {};
+  if (!gdk_rgba_parse(&color, value)) {
+    return false;
+  }
+  if (!gdk_rgba_equal(&color, &palette->colors[index])) {
+    palette->colors[index] = color;
+    palette->dirty = true;
+  }
+  return true;
+}
+
+void palette_apply(Palette* palette, VteTerminal* vte)
+{
+  if (!palette->dirty) {
+    return;
+  }
+  vte_terminal_set_colors(vte, NULL, NULL, palette->colors, PALETTE_SIZE);
+  palette->dirty = false;
+}
@@ -0,0 +1,33 @@
+/**
+ * palette_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "palette.h"
+
+
+void test_palette()
+{
+  Palette* palette = palette_init();
+  g_assert_true(palette->dirty);
+  palette->dirty = false;
+
+  g_assert_true(palette_set_color(palette, 1, "#ff0000"));
+  g_assert_true(palette->dirty);
+  g_assert_cmpfloat(palette->colors[1].red, ==, 1.0);
+  g_assert_cmpfloat(palette->colors[1].green, ==, 0.0);
+
+  palette->dirty = false;
+  g_assert_true(palette_set_color(palette, 1, "rgb(255,0,0)"));
+  g_assert_false(palette->dirty);
+
+  g_assert_false(palette_set_color(palette, 2, "invalid color"));
+  g_assert_false(palette->dirty);
+
+  palette_close(palette);
+}
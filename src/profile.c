@@ -0,0 +1,97 @@
+/**
+ * profile.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "profile.h"
+
+
+typedef struct {
+  char* label;
+  gint64 start;
+  gint64 end;
+} ProfileEntry;
+
+
+static void free_entry(void* data)
+{
+  g_free(((ProfileEntry*)data)->label);
+  g_free(data);
+}
+
+Profile* profile_init(const char* format)
+{
+  Profile* profile = g_malloc0(sizeof(Profile));
+  profile->entries = g_ptr_array_new_with_free_func(free_entry);
+  profile->origin = g_get_monotonic_time();
+  profile->json = is_equal(format, TYM_PROFILE_FORMAT_JSON);
+  return profile;
+}
+
+void profile_close(Profile* profile)
+{
+  g_ptr_array_unref(profile->entries);
+  g_free(profile);
+}
+
+// All functions below accept NULL so that callers do not need to check whether profiling is enabled.
+gint64 profile_begin(Profile* profile)
+{
+  if (!profile) {
+    return 0;
+  }
+  return g_get_monotonic_time();
+}
+
+void profile_end(Profile* profile, const char* label, gint64 start)
+{
+  if (!profile) {
+    return;
+  }
+  ProfileEntry* e = g_malloc0(sizeof(ProfileEntry));
+  e->label = g_strdup(label);
+  e->start = start;
+  e->end = g_get_monotonic_time();
+  g_ptr_array_add(profile->entries, e);
+}
+
+void profile_mark(Profile* profile, const char* label)
+{
+  profile_end(profile, label, profile_begin(profile));
+}
+
+static double to_ms(gint64 usec)
+{
+  return (double)usec / 1000;
+}
+
+void profile_report(Profile* profile)
+{
+  if (!profile) {
+    return;
+  }
+  if (profile->json) {
+    g_print("[");
+    for (unsigned i = 0; i < profile->entries->len; i++) {
+      ProfileEntry* e = g_ptr_array_index(profile->entries, i);
+      char* label = g_strescape(e->label, NULL);
+      g_print(
+        "%s\n  {\"label\": \"%s\", \"start_ms\": %.3f, \"duration_ms\": %.3f}",
+        i == 0 ? "" : ",",
+        label, to_ms(e->start - profile->origin), to_ms(e->end - e->start)
+      );
+      g_free(label);
+    }
+    g_print("\n]\n");
+    return;
+  }
+  g_print("%-40s %12s %12s\n", "label", "start(ms)", "duration(ms)");
+  for (unsigned i = 0; i < profile->entries->len; i++) {
+    ProfileEntry* e = g_ptr_array_index(profile->entries, i);
+    g_print("%-40s %12.3f %12.3f\n", e->label, to_ms(e->start - profile->origin), to_ms(e->end - e->start));
+  }
+}
@@ -7,6 +7,7 @@
  * of the MIT license. See the LICENSE file for details.
  */
 
+#include <glib/gstdio.h>
 #include "common.h"
 #include "property.h"
 #include "regex.h"
@@ -20,6 +21,35 @@ typedef enum {
 typedef void (*VteSetColorFunc)(VteTerminal*, const GdkRGBA*);
 
 
+static void store_str(Context* context, const char* key, const char* value)
+{
+  config_set_str(context->config, meta_get_entry(context->meta, key)->index, value);
+}
+
+static void store_int(Context* context, const char* key, int value)
+{
+  config_set_int(context->config, meta_get_entry(context->meta, key)->index, value);
+}
+
+static void store_bool(Context* context, const char* key, bool value)
+{
+  config_set_bool(context->config, meta_get_entry(context->meta, key)->index, value);
+}
+
+static bool check_non_negative(const char* key, int value)
+{
+  if (value < 0) {
+    g_message("Invalid `%s` value. (`%d` is provided). It must not be negative.", key, value);
+    return false;
+  }
+  return true;
+}
+
+static void store_color(Context* context, const char* key, const char* value)
+{
+  config_set_color(context->config, meta_get_entry(context->meta, key)->index, value);
+}
+
 static void set_size(Context* context, int width, int height)
 {
   GtkWindow* window = context->layout.window;
@@ -46,6 +76,32 @@ static void set_size(Context* context, int width, int height)
   }
 }
 
+static bool apply_uri_schemes(Context* context, const char* value);
+
+void property_commit_batch(Context* context)
+{
+  Batch batch = context->batch;
+  context->batch = (Batch){};
+  // font and scale first since the size depends on the cell size
+  if (batch.font) {
+    PangoFontDescription* font_desc = pango_font_description_from_string(context_get_str(context, "font"));
+    vte_terminal_set_font(context->layout.vte, font_desc);
+    pango_font_description_free(font_desc);
+  }
+  if (batch.scale) {
+    vte_terminal_set_font_scale(context->layout.vte, (double)batch.scale_value / 100);
+  }
+  if (batch.size) {
+    set_size(context, batch.width, batch.height);
+  }
+  if (batch.palette) {
+    palette_apply(context->palette, context->layout.vte);
+  }
+  if (batch.uri_schemes) {
+    apply_uri_schemes(context, context_get_str(context, "uri_schemes"));
+  }
+}
+
 
 // STR
 
@@ -55,7 +111,7 @@ void setter_shell(Context* context, const char* key, const char* value)
     g_message("To override `%s`, you need to set value before terminal finish initialization.`", key);
     return;
   }
-  config_set_str(context->config, key, value);
+  store_str(context, key, value);
 }
 
 void setter_term(Context* context, const char* key, const char* value)
@@ -64,7 +120,7 @@ void setter_term(Context* context, const char* key, const char* value)
     g_message("To override `%s`, you need to set value before the terminal finish initialization.`", key);
     return;
   }
-  config_set_str(context->config, key, value);
+  store_str(context, key, value);
 }
 
 const char* getter_title(Context* context, const char* key)
@@ -79,10 +135,15 @@ void setter_title(Context* context, const char* key, const char* value)
 
 void setter_font(Context* context, const char* key, const char* value)
 {
+  if (context->batch.depth > 0) {
+    context->batch.font = true;
+    store_str(context, key, value);
+    return;
+  }
   PangoFontDescription* font_desc = pango_font_description_from_string(value);
   vte_terminal_set_font(context->layout.vte, font_desc);
   pango_font_description_free(font_desc);
-  config_set_str(context->config, key, value);
+  store_str(context, key, value);
 }
 
 const char* getter_icon(Context* context, const char* key)
@@ -200,153 +261,339 @@ void setter_cjk_width(Context* context, const char* key, const char* value)
   vte_terminal_set_cjk_ambiguous_width(context->layout.vte, cjk);
 }
 
+static void update_app_paintable(Context* context)
+{
+  bool paintable = !is_empty(config_get_str(context->config, META_KEY_color_window_background))
+    || context->layout.background_pixbuf;
+  gtk_widget_set_app_paintable(GTK_WIDGET(context->layout.window), paintable);
+  gtk_widget_queue_draw(GTK_WIDGET(context->layout.window));
+}
+
+static void clear_background_image(Context* context)
+{
+  Layout* layout = &context->layout;
+  if (layout->background_cancellable) {
+    g_cancellable_cancel(layout->background_cancellable);
+    g_clear_object(&layout->background_cancellable);
+  }
+  g_clear_object(&layout->background_pixbuf);
+  g_clear_pointer(&layout->background_surface, cairo_surface_destroy);
+  g_clear_pointer(&layout->background_path, g_free);
+}
+
+static void load_background_image_thread(GTask* task, void* source_object, void* task_data, GCancellable* cancellable)
+{
+  GError* error = NULL;
+  GdkPixbuf* pixbuf = gdk_pixbuf_new_from_file((const char*)task_data, &error);
+  if (error) {
+    g_task_return_error(task, error);
+    return;
+  }
+  g_task_return_pointer(task, pixbuf, g_object_unref);
+}
+
+static void on_background_image_loaded(GObject* source_object, GAsyncResult* result, void* user_data)
+{
+  // check before touching the context because it may have been closed
+  if (g_cancellable_is_cancelled(g_task_get_cancellable(G_TASK(result)))) {
+    return;
+  }
+  Context* context = (Context*)user_data;
+  GError* error = NULL;
+  GdkPixbuf* pixbuf = g_task_propagate_pointer(G_TASK(result), &error);
+  g_clear_object(&context->layout.background_cancellable);
+  if (error) {
+    g_message("`background_image`: %s", error->message);
+    g_error_free(error);
+    return;
+  }
+  context->layout.background_pixbuf = pixbuf;
+  update_app_paintable(context);
+}
+
 void setter_background_image(Context* context, const char* key, const char* value)
 {
-  char* css;
   if (is_empty(value)) {
-    css = g_strdup("window { background-image: none; }");
+    clear_background_image(context);
+    update_app_paintable(context);
+    store_str(context, key, value);
+    return;
+  }
+  char* path;
+  if (g_path_is_absolute(value)) {
+    path = g_strdup(value);
   } else {
-    char* path;
-    if (g_path_is_absolute(value)) {
-      path = g_strdup(value);
-    } else {
-      char* cwd = g_get_current_dir();
-      path = g_build_path(G_DIR_SEPARATOR_S, cwd, value, NULL);
-      g_free(cwd);
-    }
-    if (!g_file_test(path, G_FILE_TEST_EXISTS)) {
-      g_message("`%s`: `%s` does not exist.", key, path);
-      g_free(path);
-      return;
-    }
-    css = g_strdup_printf("window { background-image: url('%s'); background-size: cover; background-position: center; }", path);
+    char* cwd = context_get_cwd(context);
+    path = g_build_path(G_DIR_SEPARATOR_S, cwd, value, NULL);
+    g_free(cwd);
+  }
+  GStatBuf st;
+  if (g_stat(path, &st) != 0) {
+    g_message("`%s`: `%s` does not exist.", key, path);
     g_free(path);
+    return;
   }
-  GtkCssProvider* css_provider = gtk_css_provider_new();
-  GError* error = NULL;
-  gtk_css_provider_load_from_data(css_provider, css, -1, &error);
-  g_free(css);
-  if (error) {
-    g_message("`%s`: Error in css: %s", key, error->message);
-    g_error_free(error);
+  Layout* layout = &context->layout;
+  gint64 mtime = (gint64)st.st_mtime;
+  bool loaded = layout->background_pixbuf || layout->background_cancellable;
+  if (loaded && g_strcmp0(layout->background_path, path) == 0 && layout->background_mtime == mtime) {
+    // reloading an unchanged image keeps the current one instead of decoding it again
+    g_free(path);
+    store_str(context, key, value);
     return;
   }
-  GtkStyleContext* style_context = gtk_widget_get_style_context(GTK_WIDGET(context->layout.window));
-  gtk_style_context_add_provider(style_context, GTK_STYLE_PROVIDER(css_provider), GTK_STYLE_PROVIDER_PRIORITY_USER);
-  config_set_str(context->config, key, value);
+  // decode off the main thread, then `on_window_draw()` paints it
+  clear_background_image(context);
+  layout->background_path = g_strdup(path);
+  layout->background_mtime = mtime;
+  GCancellable* cancellable = context->layout.background_cancellable = g_cancellable_new();
+  GTask* task = g_task_new(NULL, cancellable, on_background_image_loaded, context);
+  g_task_set_task_data(task, path, g_free);
+  g_task_run_in_thread(task, load_background_image_thread);
+  g_object_unref(task);
+  store_str(context, key, value);
 }
 
-void setter_uri_schemes(Context* context, const char* key, const char* value)
+#define URI_REGEX_FLAGS (PCRE2_UTF | PCRE2_MULTILINE | PCRE2_CASELESS)
+
+static pcre2_code* get_scheme_list_code()
 {
-  gchar* uri_pattern;
+  static pcre2_code* code = NULL;
+  if (code) {
+    return code;
+  }
+  int errorcode;
+  PCRE2_SIZE erroroffset;
+  code = pcre2_compile(
+    SCHEME_LIST,
+    PCRE2_ZERO_TERMINATED,
+    PCRE2_ANCHORED | PCRE2_CASELESS | PCRE2_ENDANCHORED,
+    &errorcode,
+    &erroroffset,
+    NULL
+  );
+  if (!code) {
+    g_warning("pcre2_compile failed for errorcode `%d` at offset `%d`\n", errorcode, (int)erroroffset);
+  }
+  return code;
+}
 
+// Returns a newly allocated pattern to match URIs of the schemes, `""` if no schemes are
+// specified or NULL if the value is invalid.
+static char* build_uri_pattern(const char* value)
+{
   if (g_strcmp0(TYM_SYMBOL_WILDCARD, value) == 0) {
-    uri_pattern = g_strconcat(SCHEME, SCHEMELESS_URI, NULL);
-  } else {
-    int errorcode;
-    PCRE2_SIZE erroroffset;
-    pcre2_code* code = pcre2_compile(
-      SCHEME_LIST,
-      PCRE2_ZERO_TERMINATED,
-      PCRE2_ANCHORED | PCRE2_CASELESS | PCRE2_ENDANCHORED,
-      &errorcode,
-      &erroroffset,
-      NULL
-    );
-    if (!code) {
-      g_warning("pcre2_compile failed for errorcode `%d` at offset `%d`\n", errorcode, (int)erroroffset);
-      return;
-    }
-
-    // repetitivelly get all schemes in the list, one by one.
-    // TODO: handle ill-formatted inputs
-    GSList* schemes = NULL;
-    int scheme_length_sum = 0;
-    const char* v = value;
-    while (true) {
-      pcre2_match_data* match_data = pcre2_match_data_create_from_pattern(code, NULL);
-      int res = pcre2_match(
-          code,
-          v,
-          PCRE2_ZERO_TERMINATED,
-          0,
-          PCRE2_ANCHORED | PCRE2_ENDANCHORED | PCRE2_NOTEMPTY,
-          match_data,
-          NULL
-      );
-
-      if (res <= 0) {
-        switch (res) {
-        case 0:
-          g_warning("Ovector was not big enough. This should not happen.");
-          break;
-        case PCRE2_ERROR_NOMATCH:
-          g_warning("No match\n");
-          break;
-        default:
-          g_warning("PCRE2 match error %d\n", res);
-          break;
-        }
-        pcre2_match_data_free(match_data);
-        pcre2_code_free(code);
-        return;
-      }
+    return g_strconcat(SCHEME, SCHEMELESS_URI, NULL);
+  }
+  pcre2_code* code = get_scheme_list_code();
+  if (!code) {
+    return NULL;
+  }
 
-      PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(match_data);
-      int length = ovector[3] - ovector[2];
-      if (length > 0) {
-          schemes = g_slist_prepend(schemes, g_strndup(v + ovector[2], length)); // get first scheme
-          scheme_length_sum += length + 1; // 1 for separater `|` or terminal null char
-      }
+  // repetitivelly get all schemes in the list, one by one.
+  // TODO: handle ill-formatted inputs
+  GSList* schemes = NULL;
+  int scheme_length_sum = 0;
+  const char* v = value;
+  pcre2_match_data* match_data = pcre2_match_data_create_from_pattern(code, NULL);
+  while (true) {
+    int res = pcre2_match(
+        code,
+        v,
+        PCRE2_ZERO_TERMINATED,
+        0,
+        PCRE2_ANCHORED | PCRE2_ENDANCHORED | PCRE2_NOTEMPTY,
+        match_data,
+        NULL
+    );
 
-      if (ovector[1] > ovector[3]) {
-        // there is at least one more scheme in the list, so move the pointer forward
-        v = &v[ovector[3] + 1];
-      } else {
+    if (res <= 0) {
+      switch (res) {
+      case 0:
+        g_warning("Ovector was not big enough. This should not happen.");
+        break;
+      case PCRE2_ERROR_NOMATCH:
+        g_warning("No match\n");
+        break;
+      default:
+        g_warning("PCRE2 match error %d\n", res);
         break;
       }
       pcre2_match_data_free(match_data);
+      g_slist_free_full(schemes, g_free);
+      return NULL;
     }
-    pcre2_code_free(code);
-
-    // if no schemes specified, remove current regex and return immediately
-    if (scheme_length_sum == 0) {
-      if (context->layout.uri_tag >= 0) {
-        vte_terminal_match_remove(context->layout.vte, context->layout.uri_tag);
-        context->layout.uri_tag = -1;
-        config_set_str(context->config, key, value);
-      }
-      return;
+
+    PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(match_data);
+    int length = ovector[3] - ovector[2];
+    if (length > 0) {
+        schemes = g_slist_prepend(schemes, g_strndup(v + ovector[2], length)); // get first scheme
+        scheme_length_sum += length + 1; // 1 for separater `|` or terminal null char
     }
 
-    gchar scheme_pattern[scheme_length_sum];
-    gchar* p = scheme_pattern;
-    for (GSList* scheme = schemes; scheme; scheme = scheme->next) {
-      p = g_stpcpy(p, scheme->data);
-      *p = '|';
-      ++p;
+    if (ovector[1] > ovector[3]) {
+      // there is at least one more scheme in the list, so move the pointer forward
+      v = &v[ovector[3] + 1];
+    } else {
+      break;
     }
-    scheme_pattern[scheme_length_sum - 1] = '\0'; // replace last `|` with null char
-    uri_pattern = g_strconcat("(?:", scheme_pattern, ")", SCHEMELESS_URI, NULL);
-    g_slist_free_full(schemes, g_free);
   }
+  pcre2_match_data_free(match_data);
 
-  GError* error = NULL;
-  VteRegex* regex = vte_regex_new_for_match(uri_pattern, -1, PCRE2_UTF | PCRE2_MULTILINE | PCRE2_CASELESS, &error);
+  if (scheme_length_sum == 0) {
+    return g_strdup("");
+  }
+
+  gchar scheme_pattern[scheme_length_sum];
+  gchar* p = scheme_pattern;
+  for (GSList* scheme = schemes; scheme; scheme = scheme->next) {
+    p = g_stpcpy(p, scheme->data);
+    *p = '|';
+    ++p;
+  }
+  scheme_pattern[scheme_length_sum - 1] = '\0'; // replace last `|` with null char
+  g_slist_free_full(schemes, g_free);
+  return g_strconcat("(?:", scheme_pattern, ")", SCHEMELESS_URI, NULL);
+}
+
+// A compiled regex for a value of `uri_schemes`, shared by the windows which use it.
+typedef struct {
+  VteRegex* regex; // NULL when the value specifies no schemes
+  unsigned refs;
+} UriRegex;
+
+static void uri_regex_free(void* data)
+{
+  UriRegex* entry = (UriRegex*)data;
+  g_clear_pointer(&entry->regex, vte_regex_unref);
+  g_free(entry);
+}
+
+// The key also has the flags, since a regex compiled with other flags matches differently.
+static char* uri_regex_key(const char* value)
+{
+  return g_strdup_printf("%x:%s", URI_REGEX_FLAGS, value);
+}
+
+// The windows of the daemon share the cache of the primary context, which frees it on close.
+static GHashTable* get_uri_regexes(Context* context)
+{
+  Context* primary = context->primary ? context->primary : context;
+  if (!primary->uri_regexes) {
+    primary->uri_regexes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, uri_regex_free);
+  }
+  return primary->uri_regexes;
+}
+
+// Returns the entry for the value with a new reference, or NULL if the value is invalid.
+static UriRegex* acquire_uri_regex(Context* context, const char* value)
+{
+  GHashTable* cache = get_uri_regexes(context);
+  char* key = uri_regex_key(value);
+  UriRegex* entry = g_hash_table_lookup(cache, key);
+  if (entry) {
+    g_free(key);
+    entry->refs += 1;
+    return entry;
+  }
+
+  char* uri_pattern = build_uri_pattern(value);
+  if (!uri_pattern) {
+    g_free(key);
+    return NULL;
+  }
+  VteRegex* regex = NULL;
+  if (!is_empty(uri_pattern)) {
+    GError* error = NULL;
+    regex = vte_regex_new_for_match(uri_pattern, -1, URI_REGEX_FLAGS, &error);
+    if (error) {
+      g_warning("Error when adding regex to VTE: %s", error->message);
+      g_error_free(error);
+      g_free(uri_pattern);
+      g_free(key);
+      return NULL;
+    }
+    // hover and click matching run this on every motion, so compile it to machine code
+    if (!vte_regex_jit(regex, PCRE2_JIT_COMPLETE, &error)) {
+      dd("JIT is not available for the URI regex: %s", error->message);
+      g_error_free(error);
+    }
+  }
   g_free(uri_pattern);
+  entry = g_malloc0(sizeof(UriRegex));
+  entry->regex = regex;
+  entry->refs = 1;
+  g_hash_table_insert(cache, key, entry);
+  return entry;
+}
+
+// Drops the reference of the window, and the regex once no window uses it.
+static void release_uri_regex(Context* context, const char* value)
+{
+  GHashTable* cache = get_uri_regexes(context);
+  char* key = uri_regex_key(value);
+  UriRegex* entry = g_hash_table_lookup(cache, key);
+  if (entry) {
+    entry->refs -= 1;
+    if (entry->refs == 0) {
+      g_hash_table_remove(cache, key);
+    }
+  }
+  g_free(key);
+}
 
-  if (error) {
-    g_warning("Error when adding regex to VTE: %s", error->message);
-    g_error_free(error);
-  } else {
-    if (context->layout.uri_tag >= 0) {
-      vte_terminal_match_remove(context->layout.vte, context->layout.uri_tag);
+// Returns false if the value is invalid.
+static bool apply_uri_schemes(Context* context, const char* value)
+{
+  Layout* layout = &context->layout;
+  // reloading an unchanged value does nothing
+  if (layout->uri_schemes && g_str_equal(value, layout->uri_schemes)) {
+    return true;
+  }
+  UriRegex* entry = acquire_uri_regex(context, value);
+  if (!entry) {
+    return false;
+  }
+  if (layout->uri_tag >= 0) {
+    vte_terminal_match_remove(layout->vte, layout->uri_tag);
+    layout->uri_tag = -1;
+  }
+  property_release_uri_regex(context);
+  layout->uri_regex = entry->regex;
+  layout->uri_schemes = g_strdup(value);
+  if (entry->regex) {
+    int tag = vte_terminal_match_add_regex(layout->vte, entry->regex, 0);
+    layout->uri_tag = tag;
+    vte_terminal_match_set_cursor_name(layout->vte, tag, "hand");
+  }
+  return true;
+}
+
+void property_release_uri_regex(Context* context)
+{
+  Layout* layout = &context->layout;
+  if (layout->uri_schemes) {
+    release_uri_regex(context, layout->uri_schemes);
+    g_clear_pointer(&layout->uri_schemes, g_free);
+  }
+  layout->uri_regex = NULL;
+}
+
+void setter_uri_schemes(Context* context, const char* key, const char* value)
+{
+  if (context->batch.depth > 0) {
+    // only the last value is compiled, since a reload restores the default before the config sets it again
+    char* uri_pattern = build_uri_pattern(value);
+    if (!uri_pattern) {
+      return;
     }
-    int tag = vte_terminal_match_add_regex(context->layout.vte, regex, 0);
-    context->layout.uri_tag = tag;
-    vte_terminal_match_set_cursor_name(context->layout.vte, tag, "hand");
-    vte_regex_unref(regex);
-    config_set_str(context->config, key, value);
+    g_free(uri_pattern);
+    context->batch.uri_schemes = true;
+    store_str(context, key, value);
+    return;
+  }
+  if (apply_uri_schemes(context, value)) {
+    store_str(context, key, value);
   }
 }
 
@@ -354,44 +601,72 @@ void setter_uri_schemes(Context* context, const char* key, const char* value)
 
 int getter_width(Context* context, const char* key)
 {
+  if (context->batch.size) {
+    return context->batch.width;
+  }
   return vte_terminal_get_column_count(context->layout.vte);
 }
 
 void setter_width(Context* context, const char* key, int value)
 {
-  set_size(context, value, context_get_int(context, "height"));
+  int height = context_get_int(context, "height");
+  if (context->batch.depth > 0) {
+    context->batch.size = true;
+    context->batch.width = value;
+    context->batch.height = height;
+    return;
+  }
+  set_size(context, value, height);
 }
 
 int getter_height(Context* context, const char* key)
 {
+  if (context->batch.size) {
+    return context->batch.height;
+  }
   return vte_terminal_get_row_count(context->layout.vte);
 }
 
 void setter_height(Context* context, const char* key, int value)
 {
-  set_size(context, context_get_int(context, "width"), value);
+  int width = context_get_int(context, "width");
+  if (context->batch.depth > 0) {
+    context->batch.size = true;
+    context->batch.width = width;
+    context->batch.height = value;
+    return;
+  }
+  set_size(context, width, value);
 }
 
 int getter_scale(Context* context, const char* key)
 {
+  if (context->batch.scale) {
+    return context->batch.scale_value;
+  }
   return roundup(vte_terminal_get_font_scale(context->layout.vte) * 100);
 }
 
 void setter_scale(Context* context, const char* key, int value)
 {
+  if (context->batch.depth > 0) {
+    context->batch.scale = true;
+    context->batch.scale_value = value;
+    return;
+  }
   vte_terminal_set_font_scale(context->layout.vte, (double)value / 100);
 }
 
 void setter_padding_horizontal(Context* context, const char* key, int value)
 {
   gtk_box_set_child_packing(context->layout.hbox, GTK_WIDGET(context->layout.vte), true, true, value, GTK_PACK_START);
-  config_set_int(context->config, key, value);
+  store_int(context, key, value);
 }
 
 void setter_padding_vertical(Context* context, const char* key, int value)
 {
   gtk_box_set_child_packing(context->layout.vbox, GTK_WIDGET(context->layout.hbox), true, true, value, GTK_PACK_START);
-  config_set_int(context->config, key, value);
+  store_int(context, key, value);
 }
 
 int getter_scrollback_length(Context* context, const char* key)
@@ -404,9 +679,112 @@ void setter_scrollback_length(Context* context, const char* key, int value)
   vte_terminal_set_scrollback_lines(context->layout.vte, value);
 }
 
+void setter_keymap_timeout(Context* context, const char* key, int value)
+{
+  if (!check_non_negative(key, value)) {
+    return;
+  }
+  keymap_set_timeout(context->keymap, value);
+  store_int(context, key, value);
+}
+
+void setter_timer_slack(Context* context, const char* key, int value)
+{
+  if (!check_non_negative(key, value)) {
+    return;
+  }
+  // the timers read it when the Lua context is loaded
+  if (context->timer) {
+    timer_set_slack(context->timer, value);
+  }
+  store_int(context, key, value);
+}
+
+void setter_lua_time_budget(Context* context, const char* key, int value)
+{
+  if (!check_non_negative(key, value)) {
+    return;
+  }
+  store_int(context, key, value);
+  context_apply_lua_budget(context);
+}
+
+void setter_lua_memory_limit(Context* context, const char* key, int value)
+{
+  if (!check_non_negative(key, value)) {
+    return;
+  }
+  if (context->memory) {
+    memory_set_limit(context->memory, (size_t)value * 1024 * 1024);
+  }
+  store_int(context, key, value);
+}
+
+void setter_gc_mode(Context* context, const char* key, const char* value)
+{
+  bool generational = false;
+  if (is_equal(value, TYM_GC_MODE_INCREMENTAL)) {
+  } else if (is_equal(value, TYM_GC_MODE_GENERATIONAL)) {
+    generational = true;
+  } else {
+    g_message("Invalid `gc_mode` value. (`%s` is provided). '" \
+        TYM_GC_MODE_INCREMENTAL "' or '" TYM_GC_MODE_GENERATIONAL "' is available.", value);
+    return;
+  }
+  if (context->collector && !collector_set_generational(context->collector, generational)) {
+    g_message("`gc_mode` '" TYM_GC_MODE_GENERATIONAL "' requires Lua 5.4. Ignored.");
+    return;
+  }
+  store_str(context, key, value);
+}
+
+void setter_gc_idle_delay(Context* context, const char* key, int value)
+{
+  if (!check_non_negative(key, value)) {
+    return;
+  }
+  if (context->collector) {
+    collector_set_idle_delay(context->collector, value);
+  }
+  store_int(context, key, value);
+}
+
+void setter_gc_pause(Context* context, const char* key, int value)
+{
+  if (!check_non_negative(key, value)) {
+    return;
+  }
+  store_int(context, key, value);
+  context_apply_gc_params(context);
+}
+
+void setter_gc_step_multiplier(Context* context, const char* key, int value)
+{
+  if (!check_non_negative(key, value)) {
+    return;
+  }
+  store_int(context, key, value);
+  context_apply_gc_params(context);
+}
+
+void setter_lua_instruction_budget(Context* context, const char* key, int value)
+{
+  if (!check_non_negative(key, value)) {
+    return;
+  }
+  store_int(context, key, value);
+  context_apply_lua_budget(context);
+}
+
 
 // BOOL
 
+void setter_ignore_default_keymap(Context* context, const char* key, bool value)
+{
+  keymap_set_ignore_default(context->keymap, value);
+  store_bool(context, key, value);
+}
+
 bool getter_silent(Context* context, const char* key)
 {
   return !vte_terminal_get_audible_bell(context->layout.vte);
@@ -437,7 +815,7 @@ static void setter_color_special(Context* context, const char* key, const char*
     return;
   }
   color_func(context->layout.vte, &color);
-  config_set_str(context->config, key, value);
+  store_color(context, key, value);
 }
 
 void setter_color_normal(Context* context, const char* key, const char* value)
@@ -446,37 +824,24 @@ void setter_color_normal(Context* context, const char* key, const char* value)
   if (is_equal(value, context_get_str(context, key))) {
     return;
   }
-  char* target = NULL;
-  int index = g_ascii_strtoull(&key[6], &target, 10);
-  GdkRGBA* palette = g_new0(GdkRGBA, 16);
-  assert(&key[6] != target || index < 0 || index > 15);
-  char s[10] = {};
-  unsigned i = 0;
-  while (i < 16) {
-    const char* v;
-    if (i == index) {
-      v = value;
-    } else {
-      g_snprintf(s, 10, "color_%d", i);
-      v = context_get_str(context, s);
-    }
-    bool valid = gdk_rgba_parse(&palette[i], v);
-    if (!valid) {
-      g_message("Invalid color string for '%s': %s", key, value);
-      return;
-    }
-    i += 1;
+  unsigned index = meta_get_entry(context->meta, key)->index - META_KEY_color_0;
+  if (!palette_set_color(context->palette, index, value)) {
+    g_message("Invalid color string for '%s': %s", key, value);
+    return;
   }
-  vte_terminal_set_colors(context->layout.vte, NULL, NULL, palette, 16);
-  config_set_str(context->config, key, value);
-  g_free(palette);
+  store_str(context, key, value);
+  if (context->batch.depth > 0) {
+    context->batch.palette = true;
+    return;
+  }
+  palette_apply(context->palette, context->layout.vte);
 }
 
 void setter_color_window_background(Context* context, const char* key, const char* value)
 {
   if (is_empty(value)) {
-    gtk_widget_set_app_paintable(GTK_WIDGET(context->layout.window), false);
-    config_set_str(context->config, key, value);
+    store_str(context, key, value);
+    update_app_paintable(context);
     return;
   }
 
@@ -487,11 +852,10 @@ void setter_color_window_background(Context* context, const char* key, const cha
       g_message("Invalid color string for '%s': %s", key, value);
       return;
     }
-  } else {
-    gtk_widget_queue_draw(GTK_WIDGET(context->layout.window));
   }
-  gtk_widget_set_app_paintable(GTK_WIDGET(context->layout.window), true);
-  config_set_str(context->config, key, value);
+  // the parsed color is what `on_window_draw()` paints
+  store_color(context, key, value);
+  update_app_paintable(context);
 }
 
 void setter_color_background(Context* context, const char* key, const char* value)
@@ -499,7 +863,7 @@ void setter_color_background(Context* context, const char* key, const char* valu
   if (is_none(value)) {
 #ifdef TYM_USE_TRANSPARENT
     vte_terminal_set_clear_background(context->layout.vte, false);
-    config_set_str(context->config, key, value);
+    store_str(context, key, value);
 #else
     g_message("`NONE` for `color_background` is supported on VTE version>=0.52 (your VTE version is %s)", TYM_VTE_VERSION);
 #endif
@@ -0,0 +1,109 @@
+/**
+ * regex_bench.c
+ *
+ * Times the URI regex on lines which match and do not match, including pathological ones,
+ * in the same way as VTE runs it. Run by `make bench-regex`.
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "common.h"
+#include "regex.h"
+
+
+#define URI SCHEME SCHEMELESS_URI
+// same as `vte_regex_new_for_match()`
+#define COMPILE_FLAGS (PCRE2_UTF | PCRE2_NO_UTF_CHECK | PCRE2_MULTILINE | PCRE2_CASELESS | PCRE2_NEVER_BACKSLASH_C | PCRE2_USE_OFFSET_LIMIT)
+#define LINE_LENGTH 4096
+#define MIN_DURATION_US 200000
+
+typedef struct {
+  const char* name;
+  char* line;
+} BenchCase;
+
+
+static char* repeat(const char* unit, const char* tail)
+{
+  char* line = g_malloc0(LINE_LENGTH + strlen(tail) + 1);
+  size_t unit_length = strlen(unit);
+  size_t length = 0;
+  while (length + unit_length <= LINE_LENGTH) {
+    memcpy(&line[length], unit, unit_length);
+    length += unit_length;
+  }
+  strcpy(&line[length], tail);
+  return line;
+}
+
+static double bench(pcre2_code* code, const char* line, int* matches, int* errors)
+{
+  pcre2_match_data* match_data = pcre2_match_data_create_from_pattern(code, NULL);
+  size_t length = strlen(line);
+  unsigned iterations = 0;
+  gint64 started_at = g_get_monotonic_time();
+  gint64 elapsed = 0;
+  do {
+    // find all matches in the line like VTE does on hover
+    PCRE2_SIZE offset = 0;
+    *matches = 0;
+    *errors = 0;
+    while (offset < length) {
+      int res = pcre2_match(code, (PCRE2_SPTR)line, length, offset, PCRE2_NO_UTF_CHECK | PCRE2_NOTEMPTY, match_data, NULL);
+      if (res <= 0) {
+        // like hitting the match limit by backtracking
+        if (res != PCRE2_ERROR_NOMATCH) {
+          *errors += 1;
+        }
+        break;
+      }
+      *matches += 1;
+      offset = pcre2_get_ovector_pointer(match_data)[1];
+    }
+    iterations += 1;
+    elapsed = g_get_monotonic_time() - started_at;
+  } while (elapsed < MIN_DURATION_US);
+  pcre2_match_data_free(match_data);
+  return (double)elapsed / iterations;
+}
+
+int main(int argc, char** argv)
+{
+  int errorcode;
+  PCRE2_SIZE erroroffset;
+  pcre2_code* interp = pcre2_compile((PCRE2_SPTR)URI, PCRE2_ZERO_TERMINATED, COMPILE_FLAGS, &errorcode, &erroroffset, NULL);
+  pcre2_code* jit = pcre2_compile((PCRE2_SPTR)URI, PCRE2_ZERO_TERMINATED, COMPILE_FLAGS, &errorcode, &erroroffset, NULL);
+  if (!interp || !jit) {
+    printf("pcre2_compile failed for errorcode `%d` at offset `%d`\n", errorcode, (int)erroroffset);
+    return 1;
+  }
+  bool jit_available = pcre2_jit_compile(jit, PCRE2_JIT_COMPLETE) == 0;
+
+  BenchCase cases[] = {
+    { "log line with URIs", repeat("GET https://example.com/api/v1/items?id=42&sort=desc#top 200 OK ", "") },
+    { "ls output",          repeat("drwxr-xr-x 2 user user 4096 Jan  1 00:00 some-directory ", "") },
+    { "base64 blob",        repeat("aHR0cDovL2V4YW1wbGUuY29tL2Zvbz9iYXI9YmF6", "") },
+    { "minified js",        repeat("a.b=function(c){return c&&c.d?c.e:f(g,h)};", "") },
+    { "scheme-like runs",   repeat("http:a:b:c:", "") },
+    { "long authority",     repeat("%41!$&'()*+,;=", "http://") },
+    { "long path",          repeat("/seg", "http://a") },
+    { "unclosed ipv6",      repeat("http://[1:2:3:4:5:6:7:", "") },
+  };
+
+  printf("%-20s %8s %8s %14s %14s\n", "case", "matches", "errors", "interp(us)", jit_available ? "jit(us)" : "jit(n/a)");
+  for (unsigned i = 0; i < G_N_ELEMENTS(cases); i++) {
+    int matches = 0;
+    int errors = 0;
+    double interp_us = bench(interp, cases[i].line, &matches, &errors);
+    double jit_us = jit_available ? bench(jit, cases[i].line, &matches, &errors) : 0;
+    printf("%-20s %8d %8d %14.2f %14.2f\n", cases[i].name, matches, errors, interp_us, jit_us);
+    g_free(cases[i].line);
+  }
+
+  pcre2_code_free(interp);
+  pcre2_code_free(jit);
+  return 0;
+}
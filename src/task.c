@@ -0,0 +1,136 @@
+/**
+ * task.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "task.h"
+
+
+static const char* TASK_PRIORITY_NAMES[TASK_PRIORITY_COUNT] = {
+  [TASK_PRIORITY_HIGH] = "high",
+  [TASK_PRIORITY_NORMAL] = "normal",
+  [TASK_PRIORITY_IDLE] = "idle",
+};
+
+static const int TASK_SOURCE_PRIORITIES[TASK_PRIORITY_COUNT] = {
+  [TASK_PRIORITY_HIGH] = G_PRIORITY_HIGH_IDLE,
+  [TASK_PRIORITY_NORMAL] = G_PRIORITY_DEFAULT_IDLE,
+  [TASK_PRIORITY_IDLE] = G_PRIORITY_LOW,
+};
+
+TaskQueue* task_init()
+{
+  TaskQueue* queue = g_malloc0(sizeof(TaskQueue));
+  for (unsigned i = 0; i < TASK_PRIORITY_COUNT; i++) {
+    queue->classes[i].queue = queue;
+    queue->classes[i].priority = i;
+    g_queue_init(&queue->classes[i].tasks);
+  }
+  return queue;
+}
+
+static void task_free(Task* task)
+{
+  if (task->destroy) {
+    task->destroy(task->data);
+  }
+  if (task->L) {
+    luaL_unref(task->L, LUA_REGISTRYINDEX, task->ref);
+  }
+  g_free(task);
+}
+
+// Must be called before `lua_close()`. The pending tasks are dropped.
+void task_close(TaskQueue* queue)
+{
+  for (unsigned i = 0; i < TASK_PRIORITY_COUNT; i++) {
+    TaskClass* class = &queue->classes[i];
+    if (class->tag) {
+      g_source_remove(class->tag);
+    }
+    while (!g_queue_is_empty(&class->tasks)) {
+      task_free((Task*)g_queue_pop_head(&class->tasks));
+    }
+  }
+  g_free(queue);
+}
+
+bool task_parse_priority(const char* name, TaskPriority* priority)
+{
+  for (unsigned i = 0; i < TASK_PRIORITY_COUNT; i++) {
+    if (is_equal(TASK_PRIORITY_NAMES[i], name)) {
+      *priority = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void task_run(Task* task)
+{
+  if (task->func) {
+    task->func(task->data);
+    return;
+  }
+  lua_State* L = task->L;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, task->ref);
+  MemoryPhase phase = memory_set_phase(L, MEMORY_PHASE_TASK);
+  int status = coro_run(L, 0, 0);
+  memory_set_phase(L, phase);
+  if (status != LUA_OK && status != LUA_YIELD) {
+    luaX_warn(L, "Error in deferred function: '%s'", lua_tostring(L, -1));
+    lua_pop(L, 1); // error
+  }
+}
+
+// Runs tasks for a slice and gives the main loop back, so that the sources of higher priority are
+// dispatched between slices even while the queue is long.
+static gboolean on_task_idle(void* user_data)
+{
+  TaskClass* class = (TaskClass*)user_data;
+  gint64 until = g_get_monotonic_time() + TASK_SLICE_USEC;
+  while (!g_queue_is_empty(&class->tasks)) {
+    Task* task = (Task*)g_queue_pop_head(&class->tasks);
+    task_run(task);
+    task_free(task);
+    if (g_get_monotonic_time() >= until) {
+      break;
+    }
+  }
+  if (g_queue_is_empty(&class->tasks)) {
+    class->tag = 0;
+    return G_SOURCE_REMOVE;
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+static void task_enqueue(TaskQueue* queue, TaskPriority priority, Task* task)
+{
+  TaskClass* class = &queue->classes[priority];
+  g_queue_push_tail(&class->tasks, task);
+  if (!class->tag) {
+    class->tag = g_idle_add_full(TASK_SOURCE_PRIORITIES[priority], on_task_idle, class, NULL);
+  }
+}
+
+void task_push(TaskQueue* queue, TaskPriority priority, TaskFunc func, void* data, GDestroyNotify destroy)
+{
+  Task* task = g_malloc0(sizeof(Task));
+  task->func = func;
+  task->data = data;
+  task->destroy = destroy;
+  task_enqueue(queue, priority, task);
+}
+
+// Takes `ref`, which is unref-ed after the function is called.
+void task_push_lua(TaskQueue* queue, TaskPriority priority, lua_State* L, int ref)
+{
+  Task* task = g_malloc0(sizeof(Task));
+  task->L = L;
+  task->ref = ref;
+  task_enqueue(queue, priority, task);
+}
@@ -0,0 +1,61 @@
+/**
+ * task_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "task.h"
+
+
+typedef struct {
+  GString* order;
+  char c;
+} Mark;
+
+static void mark(void* data)
+{
+  Mark* m = (Mark*)data;
+  g_string_append_c(m->order, m->c);
+}
+
+void test_task()
+{
+  lua_State* L = luaL_newstate();
+  luaL_openlibs(L);
+  TaskQueue* queue = task_init();
+  GString* order = g_string_new(NULL);
+
+  Mark idle = { order, 'i' };
+  Mark normal = { order, 'n' };
+  Mark high = { order, 'h' };
+  task_push(queue, TASK_PRIORITY_IDLE, mark, &idle, NULL);
+  task_push(queue, TASK_PRIORITY_NORMAL, mark, &normal, NULL);
+  task_push(queue, TASK_PRIORITY_HIGH, mark, &high, NULL);
+  task_push(queue, TASK_PRIORITY_NORMAL, mark, &normal, NULL);
+  luaL_dostring(L, "return function() deferred = true end");
+  task_push_lua(queue, TASK_PRIORITY_IDLE, L, luaL_ref(L, LUA_REGISTRYINDEX));
+
+  while (g_main_context_iteration(NULL, false));
+  g_assert_cmpstr(order->str, ==, "hnni");
+  lua_getglobal(L, "deferred");
+  g_assert_true(lua_toboolean(L, -1));
+  lua_pop(L, 1);
+
+  TaskPriority priority;
+  g_assert_true(task_parse_priority("idle", &priority));
+  g_assert_cmpint(priority, ==, TASK_PRIORITY_IDLE);
+  g_assert_false(task_parse_priority("urgent", &priority));
+
+  // dropped on close
+  task_push(queue, TASK_PRIORITY_HIGH, mark, &high, NULL);
+  task_close(queue);
+  while (g_main_context_iteration(NULL, false));
+  g_assert_cmpstr(order->str, ==, "hnni");
+
+  g_string_free(order, true);
+  lua_close(L);
+}
@@ -0,0 +1,189 @@
+/**
+ * timer.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "timer.h"
+
+
+static void timer_schedule(Timer* timer);
+
+Timer* timer_init(lua_State* L)
+{
+  Timer* timer = g_malloc0(sizeof(Timer));
+  timer->L = L;
+  return timer;
+}
+
+static void timer_entry_free(Timer* timer, TimerEntry* entry)
+{
+  luaL_unref(timer->L, LUA_REGISTRYINDEX, entry->ref);
+  g_free(entry);
+}
+
+// Must be called before `lua_close()`.
+void timer_close(Timer* timer)
+{
+  if (timer->tag) {
+    g_source_remove(timer->tag);
+  }
+  for (GList* l = timer->queue; l; l = l->next) {
+    timer_entry_free(timer, (TimerEntry*)l->data);
+  }
+  g_list_free(timer->queue);
+  g_free(timer);
+}
+
+void timer_set_slack(Timer* timer, int msec)
+{
+  timer->slack = MAX(msec, 0) * 1000;
+  timer_schedule(timer);
+}
+
+static int compare_deadline(const void* a, const void* b)
+{
+  gint64 x = ((const TimerEntry*)a)->deadline;
+  gint64 y = ((const TimerEntry*)b)->deadline;
+  return x < y ? -1 : x > y;
+}
+
+static void timer_enqueue(Timer* timer, TimerEntry* entry)
+{
+  // entries of the same deadline run in the order they were added
+  timer->queue = g_list_insert_sorted(timer->queue, entry, compare_deadline);
+}
+
+static bool timer_run(Timer* timer, TimerEntry* entry)
+{
+  lua_State* L = timer->L;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, entry->ref);
+  if (!lua_isfunction(L, -1)) {
+    lua_pop(L, 1); // pop none-function
+    dd("tried to call non-function");
+    return false;
+  }
+  MemoryPhase phase = memory_set_phase(L, MEMORY_PHASE_TIMER);
+  int status = coro_run(L, 0, 1);
+  memory_set_phase(L, phase);
+  if (status == LUA_YIELD) {
+    // the suspended function cannot ask to be repeated
+    return entry->fixed;
+  }
+  if (status != LUA_OK) {
+    luaX_warn(L, "Error in timeout function: '%s'", lua_tostring(L, -1));
+    lua_pop(L, 1); // error
+    return entry->fixed;
+  }
+  bool result = lua_toboolean(L, -1);
+  lua_pop(L, 1);
+  return entry->fixed || result;
+}
+
+static gboolean on_timer_wakeup(void* user_data)
+{
+  Timer* timer = (Timer*)user_data;
+  timer->tag = 0;
+  if (timer->running) {
+    // the outer wakeup schedules the next one when it finishes
+    return G_SOURCE_REMOVE;
+  }
+  timer->running = true;
+  gint64 now = g_get_monotonic_time();
+
+  // Entries added or re-armed by the functions wait for the next wakeup.
+  while (timer->queue && ((TimerEntry*)timer->queue->data)->deadline <= now) {
+    GList* head = timer->queue;
+    timer->queue = g_list_remove_link(timer->queue, head);
+    ((TimerEntry*)head->data)->due = true;
+    timer->due = g_list_concat(timer->due, head);
+  }
+  while (timer->due) {
+    TimerEntry* entry = (TimerEntry*)timer->due->data;
+    bool repeat = !entry->cleared && timer_run(timer, entry);
+    timer->due = g_list_delete_link(timer->due, timer->due);
+    entry->due = false;
+    if (entry->cleared || !repeat) {
+      timer_entry_free(timer, entry);
+      continue;
+    }
+    if (entry->fixed) {
+      // keep the phase and skip the runs which were missed
+      entry->deadline += entry->interval;
+      if (entry->deadline <= now) {
+        entry->deadline += ((now - entry->deadline) / entry->interval + 1) * entry->interval;
+      }
+    } else {
+      entry->deadline = g_get_monotonic_time() + entry->interval;
+    }
+    timer_enqueue(timer, entry);
+  }
+  timer->running = false;
+  timer_schedule(timer);
+  return G_SOURCE_REMOVE;
+}
+
+// Wakes up once for all the deadlines within the slack after the earliest one, so no function runs early
+// and none runs later than the slack.
+static void timer_schedule(Timer* timer)
+{
+  if (!timer->queue) {
+    if (timer->tag) {
+      g_source_remove(timer->tag);
+      timer->tag = 0;
+    }
+    return;
+  }
+  gint64 limit = ((TimerEntry*)timer->queue->data)->deadline + timer->slack;
+  gint64 wakeup = 0;
+  for (GList* l = timer->queue; l && ((TimerEntry*)l->data)->deadline <= limit; l = l->next) {
+    wakeup = ((TimerEntry*)l->data)->deadline;
+  }
+  if (timer->tag) {
+    if (timer->wakeup == wakeup) {
+      return;
+    }
+    g_source_remove(timer->tag);
+  }
+  gint64 delay = wakeup - g_get_monotonic_time();
+  timer->wakeup = wakeup;
+  timer->tag = g_timeout_add(delay > 0 ? (delay + 999) / 1000 : 0, on_timer_wakeup, timer);
+}
+
+// Takes `ref`, which is unref-ed when the timer finishes or is removed.
+int timer_add(Timer* timer, int ref, int msec, bool fixed)
+{
+  TimerEntry* entry = g_malloc0(sizeof(TimerEntry));
+  entry->id = ++timer->last_id;
+  entry->ref = ref;
+  entry->interval = MAX(msec, 0) * (gint64)1000;
+  entry->fixed = fixed && entry->interval > 0;
+  entry->deadline = g_get_monotonic_time() + entry->interval;
+  timer_enqueue(timer, entry);
+  timer_schedule(timer);
+  return entry->id;
+}
+
+bool timer_remove(Timer* timer, int id)
+{
+  for (GList* l = timer->due; l; l = l->next) {
+    TimerEntry* entry = (TimerEntry*)l->data;
+    if (entry->id == id && !entry->cleared) {
+      entry->cleared = true;
+      return true;
+    }
+  }
+  for (GList* l = timer->queue; l; l = l->next) {
+    TimerEntry* entry = (TimerEntry*)l->data;
+    if (entry->id == id) {
+      timer->queue = g_list_delete_link(timer->queue, l);
+      timer_entry_free(timer, entry);
+      timer_schedule(timer);
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,104 @@
+/**
+ * timer_test.c
+ *
+ * Copyright (c) 2020 endaaman
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "tym_test.h"
+#include "timer.h"
+
+
+static int ref_function(lua_State* L, const char* code)
+{
+  luaL_dostring(L, code);
+  return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+static int get_int(lua_State* L, const char* name)
+{
+  lua_getglobal(L, name);
+  int value = lua_tointeger(L, -1);
+  lua_pop(L, 1);
+  return value;
+}
+
+static int count_functions(lua_State* L)
+{
+  int count = 0;
+  lua_pushnil(L);
+  while (lua_next(L, LUA_REGISTRYINDEX)) {
+    count += lua_isfunction(L, -1);
+    lua_pop(L, 1);
+  }
+  return count;
+}
+
+static void iterate_for(gint64 msec)
+{
+  gint64 deadline = g_get_monotonic_time() + msec * 1000;
+  while (g_get_monotonic_time() < deadline) {
+    g_main_context_iteration(NULL, false);
+    g_usleep(1000);
+  }
+}
+
+static int spin(lua_State* L)
+{
+  iterate_for(luaL_checkinteger(L, 1));
+  return 0;
+}
+
+static int rearm(lua_State* L)
+{
+  Timer* timer = (Timer*)lua_touserdata(L, lua_upvalueindex(1));
+  lua_pushvalue(L, 1);
+  timer_add(timer, luaL_ref(L, LUA_REGISTRYINDEX), 0, false);
+  return 0;
+}
+
+void test_timer()
+{
+  lua_State* L = luaL_newstate();
+  luaL_openlibs(L);
+  luaL_dostring(L, "once = 0 twice = 0 ticks = 0");
+  int before = count_functions(L);
+
+  Timer* timer = timer_init(L);
+  timer_set_slack(timer, 20);
+  timer_add(timer, ref_function(L, "return function() once = once + 1 end"), 10, false);
+  timer_add(timer, ref_function(L, "return function() twice = twice + 1 return twice < 2 end"), 10, false);
+  int interval = timer_add(timer, ref_function(L, "return function() ticks = ticks + 1 end"), 10, true);
+  int cleared = timer_add(timer, ref_function(L, "return function() once = 100 end"), 10, false);
+  g_assert_true(timer_remove(timer, cleared));
+  g_assert_false(timer_remove(timer, cleared));
+
+  iterate_for(200);
+  g_assert_cmpint(get_int(L, "once"), ==, 1);
+  g_assert_cmpint(get_int(L, "twice"), ==, 2);
+  g_assert_cmpint(get_int(L, "ticks"), >=, 2);
+  g_assert_true(timer_remove(timer, interval));
+  g_assert_null(timer->queue);
+
+  // every finished or removed function is released
+  g_assert_cmpint(count_functions(L), ==, before);
+
+  // a function which enters a nested main loop does not let the timers run under it
+  lua_register(L, "spin", spin);
+  lua_pushlightuserdata(L, timer);
+  lua_pushcclosure(L, rearm, 1);
+  lua_setglobal(L, "rearm");
+  luaL_dostring(L, "outer = 0 inner = 0");
+  timer_add(timer, ref_function(L,
+    "return function() outer = outer + 1 rearm(function() inner = inner + 1 end) spin(50) end"
+  ), 0, false);
+  iterate_for(100);
+  g_assert_cmpint(get_int(L, "outer"), ==, 1);
+  g_assert_cmpint(get_int(L, "inner"), ==, 1);
+  g_assert_null(timer->queue);
+
+  timer_close(timer);
+  lua_close(L);
+}
@@ -12,7 +12,16 @@
 int main(int argc, char* argv[])
 {
   g_test_init(&argc, &argv, NULL);
+  g_test_add_func("/tym/collector", test_collector);
   g_test_add_func("/tym/config", test_config);
+  g_test_add_func("/tym/coro", test_coro);
+  g_test_add_func("/tym/hook", test_hook);
+  g_test_add_func("/tym/keymap", test_keymap);
+  g_test_add_func("/tym/memory", test_memory);
+  g_test_add_func("/tym/meta", test_meta);
+  g_test_add_func("/tym/palette", test_palette);
   g_test_add_func("/tym/regex", test_regex);
+  g_test_add_func("/tym/task", test_task);
+  g_test_add_func("/tym/timer", test_timer);
   return g_test_run();
 }